@@ -0,0 +1,637 @@
+/* Rendering benchmarks
+ * Measures ns/call and Mpixels/s for each graphics primitive at several
+ * sizes, alphas and clip setups, then replays full ui_demo and window_demo
+ * frames. Results go to a CSV file; --compare flags cases that got slower
+ * than a previous run's CSV.
+ *
+ * Usage: graphics_bench [--quick] [--filter TEXT] [--out FILE]
+ *                       [--compare FILE] [--threshold PERCENT]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/engine.h"
+#include "../include/ui.h"
+#include "../include/window.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+#define BENCH_MAX_BASELINE 1024
+#define BENCH_PI 3.14159265358979323846
+
+/* One line of a baseline CSV */
+typedef struct {
+    char name[96];
+    f64 ns_per_call;
+} bench_baseline_t;
+
+/* Runner settings and totals */
+static struct {
+    f64 min_time;         /* Seconds per case */
+    const char* filter;   /* Only cases whose name contains this */
+    FILE* out;
+    bench_baseline_t* baseline;
+    i32 baseline_count;
+    f64 threshold;        /* Percent slower that counts as a regression */
+    i32 cases;
+    i32 regressions;
+} g_bench = { 0.2, NULL, NULL, NULL, 0, 10.0, 0, 0 };
+
+/* A benchmark body; iteration varies per call so results cannot be hoisted */
+typedef void (*bench_fn_t)(void* state, i32 iteration);
+
+/* Shared state for the primitive cases */
+typedef struct {
+    graphics_context_t* ctx;
+    graphics_image_t* image;
+    graphics_color_t color;
+    graphics_rect_t rect;
+    i32 size;
+    graphics_filter_t filter;
+    const char* text;
+    platform_window_t* window;
+    const u32* frame;
+    i32 frame_width, frame_height;
+    platform_rect_t present_rect;
+} prim_state_t;
+
+/* Helper: Look up a case in the baseline */
+static const bench_baseline_t* find_baseline(const char* name) {
+    for (i32 i = 0; i < g_bench.baseline_count; i++) {
+        if (strcmp(g_bench.baseline[i].name, name) == 0) return &g_bench.baseline[i];
+    }
+    return NULL;
+}
+
+/* Helper: Time count calls, in seconds */
+static f64 time_calls(bench_fn_t fn, void* state, i32 count) {
+    f64 start = platform_get_time();
+    for (i32 i = 0; i < count; i++) {
+        fn(state, i);
+    }
+    return platform_get_time() - start;
+}
+
+/* Run one case: grow the call count until a batch is measurable, then keep
+ * the fastest of three batches. pixels is the area touched per call. */
+static void bench_run(const char* name, bench_fn_t fn, void* state, f64 pixels) {
+    if (g_bench.filter && !strstr(name, g_bench.filter)) return;
+    
+    fn(state, 0);
+    i32 count = 1;
+    f64 elapsed = time_calls(fn, state, count);
+    while (elapsed < g_bench.min_time / 10.0 && count < (1 << 28)) {
+        count *= 2;
+        elapsed = time_calls(fn, state, count);
+    }
+    
+    i32 batch = (i32)fmax(1.0, count * (g_bench.min_time / 3.0) / fmax(elapsed, 1e-9));
+    f64 best = elapsed / count;
+    for (i32 i = 0; i < 3; i++) {
+        f64 per_call = time_calls(fn, state, batch) / batch;
+        if (per_call < best) best = per_call;
+    }
+    
+    f64 ns = best * 1e9;
+    f64 mpix = pixels > 0 ? pixels / best / 1e6 : 0.0;
+    g_bench.cases++;
+    
+    printf("%-44s %12.1f ns/call %10.1f Mpix/s", name, ns, mpix);
+    const bench_baseline_t* base = find_baseline(name);
+    if (base && base->ns_per_call > 0) {
+        f64 change = (ns / base->ns_per_call - 1.0) * 100.0;
+        bool regressed = change > g_bench.threshold;
+        if (regressed) g_bench.regressions++;
+        printf("  %+6.1f%%%s", change, regressed ? "  REGRESSION" : "");
+    }
+    printf("\n");
+    
+    if (g_bench.out) {
+        fprintf(g_bench.out, "%s,%d,%.2f,%.2f\n", name, batch, ns, mpix);
+    }
+}
+
+/* Helper: Load a baseline CSV written by --out */
+static bool load_baseline(const char* path) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "Failed to open baseline: %s\n", path);
+        return false;
+    }
+    
+    g_bench.baseline = (bench_baseline_t*)calloc(BENCH_MAX_BASELINE, sizeof(bench_baseline_t));
+    char line[256];
+    while (g_bench.baseline && g_bench.baseline_count < BENCH_MAX_BASELINE && fgets(line, sizeof(line), fp)) {
+        bench_baseline_t* b = &g_bench.baseline[g_bench.baseline_count];
+        char* comma = strchr(line, ',');
+        if (!comma || line[0] == '#' || (size_t)(comma - line) >= sizeof(b->name)) continue;
+        
+        memcpy(b->name, line, (size_t)(comma - line));
+        b->name[comma - line] = '\0';
+        if (sscanf(comma + 1, "%*d,%lf", &b->ns_per_call) == 1) {
+            g_bench.baseline_count++;
+        }
+    }
+    fclose(fp);
+    return g_bench.baseline != NULL;
+}
+
+/* Helper: An image with the given opacity, classified the way loaded images
+ * are by a QOI round trip. Alpha images hold a gradient, binary ones holes. */
+static graphics_image_t* make_image(i32 size, graphics_opacity_t opacity) {
+    graphics_image_t* image = graphics_create_image(size, size);
+    graphics_context_t* view = graphics_create_image_view(image, NULL);
+    if (!view) return image;
+    
+    graphics_clear(view, graphics_rgba(0, 0, 0, opacity == GRAPHICS_OPACITY_OPAQUE ? 255 : 0));
+    for (i32 y = 0; y < size; y++) {
+        for (i32 x = 0; x < size; x++) {
+            u8 a = 255;
+            if (opacity == GRAPHICS_OPACITY_ALPHA) a = (u8)((x + y) * 255 / (2 * size));
+            if (opacity == GRAPHICS_OPACITY_BINARY && ((x / 4 + y / 4) & 1)) continue;
+            graphics_draw_pixel(view, x, y, graphics_rgba((u8)(x * 7), (u8)(y * 5), (u8)(x ^ y), a));
+        }
+    }
+    graphics_destroy_context(view);
+    
+    char path[] = "/tmp/graphics_bench_XXXXXX";
+    i32 fd = mkstemp(path);
+    if (fd < 0) return image;
+    close(fd);
+    
+    graphics_image_t* loaded = NULL;
+    if (graphics_save_image_qoi(image, path)) loaded = graphics_load_image(path);
+    remove(path);
+    if (!loaded) return image;
+    graphics_destroy_image(image);
+    return loaded;
+}
+
+/* Primitive bodies */
+static void run_clear(void* p, i32 i) {
+    prim_state_t* s = (prim_state_t*)p;
+    graphics_clear(s->ctx, graphics_rgb((u8)i, 40, 50));
+}
+
+static void run_fill_rect(void* p, i32 i) {
+    prim_state_t* s = (prim_state_t*)p;
+    graphics_rect_t r = s->rect;
+    r.x += i & 7;
+    graphics_fill_rect(s->ctx, &r, s->color);
+}
+
+static void run_fill_circle(void* p, i32 i) {
+    prim_state_t* s = (prim_state_t*)p;
+    graphics_fill_circle(s->ctx, s->rect.x + (i & 7), s->rect.y, s->size, s->color);
+}
+
+static void run_draw_circle(void* p, i32 i) {
+    prim_state_t* s = (prim_state_t*)p;
+    graphics_draw_circle(s->ctx, s->rect.x + (i & 7), s->rect.y, s->size, s->color);
+}
+
+static void run_fill_triangle(void* p, i32 i) {
+    prim_state_t* s = (prim_state_t*)p;
+    i32 x = s->rect.x + (i & 7), y = s->rect.y;
+    graphics_fill_triangle(s->ctx, x, y, x + s->size, y + s->size / 3, x + s->size / 4, y + s->size, s->color);
+}
+
+static void run_draw_line(void* p, i32 i) {
+    prim_state_t* s = (prim_state_t*)p;
+    i32 x = s->rect.x + (i & 7), y = s->rect.y;
+    graphics_draw_line(s->ctx, x, y, x + s->rect.width, y + s->rect.height, s->color);
+}
+
+static void run_draw_text(void* p, i32 i) {
+    prim_state_t* s = (prim_state_t*)p;
+    graphics_draw_text(s->ctx, s->text, s->rect.x + (i & 7), s->rect.y, s->color, NULL);
+}
+
+static void run_draw_image(void* p, i32 i) {
+    prim_state_t* s = (prim_state_t*)p;
+    graphics_draw_image(s->ctx, s->image, s->rect.x + (i & 7), s->rect.y);
+}
+
+static void run_draw_image_scaled(void* p, i32 i) {
+    prim_state_t* s = (prim_state_t*)p;
+    graphics_rect_t r = s->rect;
+    r.x += i & 7;
+    graphics_draw_image_scaled_ex(s->ctx, s->image, &r, s->filter);
+}
+
+static void run_present(void* p, i32 i) {
+    prim_state_t* s = (prim_state_t*)p;
+    (void)i;
+    platform_window_present_rects(s->window, s->frame, s->frame_width, s->frame_height, s->frame_width, &s->present_rect, 1);
+}
+
+/* Clip setups: none, a clip rect cutting the shape in half, or the shape
+ * hanging half off the context's bottom-right corner */
+typedef enum { CLIP_NONE, CLIP_RECT, CLIP_EDGE } clip_mode_t;
+static const char* g_clip_names[] = { "none", "cliprect", "edge" };
+
+/* Helper: Place a shape of the given extent and apply the clip setup */
+static void place_shape(prim_state_t* s, i32 extent, clip_mode_t clip, bool centered) {
+    i32 x = BENCH_WIDTH / 3, y = BENCH_HEIGHT / 3;
+    if (clip == CLIP_EDGE) {
+        x = BENCH_WIDTH - extent / 2;
+        y = BENCH_HEIGHT - extent / 2;
+        if (centered) {
+            x = BENCH_WIDTH;
+            y = BENCH_HEIGHT;
+        }
+    }
+    s->rect = graphics_rect(x, y, extent, extent);
+    
+    graphics_clear_clip_rect(s->ctx);
+    if (clip == CLIP_RECT) {
+        i32 left = centered ? x - extent / 2 : x;
+        i32 top = centered ? y - extent / 2 : y;
+        graphics_rect_t c = graphics_rect(left, top, extent / 2 + 1, extent);
+        graphics_set_clip_rect(s->ctx, &c);
+    }
+}
+
+/* Helper: Visible share of a shape under a clip setup */
+static f64 clip_share(clip_mode_t clip) {
+    return clip == CLIP_NONE ? 1.0 : clip == CLIP_RECT ? 0.5 : 0.25;
+}
+
+static void bench_primitives(graphics_context_t* ctx) {
+    static const i32 sizes[] = { 16, 64, 256 };
+    static const u8 alphas[] = { 255, 128 };
+    prim_state_t s;
+    char name[96];
+    
+    memset(&s, 0, sizeof(s));
+    s.ctx = ctx;
+    
+    /* Clear at several context sizes */
+    static const i32 clear_sizes[][2] = { { 320, 240 }, { 1280, 720 }, { BENCH_WIDTH, BENCH_HEIGHT } };
+    for (i32 i = 0; i < 3; i++) {
+        prim_state_t c = s;
+        c.ctx = graphics_create_context(clear_sizes[i][0], clear_sizes[i][1]);
+        snprintf(name, sizeof(name), "clear/%dx%d", clear_sizes[i][0], clear_sizes[i][1]);
+        bench_run(name, run_clear, &c, (f64)clear_sizes[i][0] * clear_sizes[i][1]);
+        graphics_destroy_context(c.ctx);
+    }
+    
+    for (i32 si = 0; si < 3; si++) {
+        for (i32 ai = 0; ai < 2; ai++) {
+            for (i32 clip = CLIP_NONE; clip <= CLIP_EDGE; clip++) {
+                i32 size = sizes[si];
+                s.color = graphics_rgba(200, 120, 40, alphas[ai]);
+                s.size = size;
+                const char* clip_name = g_clip_names[clip];
+                f64 share = clip_share((clip_mode_t)clip);
+                
+                place_shape(&s, size, (clip_mode_t)clip, false);
+                snprintf(name, sizeof(name), "fill_rect/%d/a%d/%s", size, alphas[ai], clip_name);
+                bench_run(name, run_fill_rect, &s, (f64)size * size * share);
+                
+                place_shape(&s, size * 2, (clip_mode_t)clip, true);
+                snprintf(name, sizeof(name), "fill_circle/r%d/a%d/%s", size, alphas[ai], clip_name);
+                bench_run(name, run_fill_circle, &s, BENCH_PI * size * size * share);
+                snprintf(name, sizeof(name), "draw_circle/r%d/a%d/%s", size, alphas[ai], clip_name);
+                bench_run(name, run_draw_circle, &s, 2.0 * BENCH_PI * size * share);
+                
+                place_shape(&s, size, (clip_mode_t)clip, false);
+                snprintf(name, sizeof(name), "fill_triangle/%d/a%d/%s", size, alphas[ai], clip_name);
+                bench_run(name, run_fill_triangle, &s, (f64)size * size * 0.4 * share);
+            }
+        }
+    }
+    graphics_clear_clip_rect(ctx);
+    
+    /* Lines by direction */
+    static const struct { const char* name; i32 dx, dy; } dirs[] = {
+        { "horizontal", 1, 0 }, { "vertical", 0, 1 }, { "diagonal", 1, 1 },
+    };
+    for (i32 li = 0; li < 2; li++) {
+        i32 length = li == 0 ? 16 : 512;
+        for (i32 d = 0; d < 3; d++) {
+            for (i32 ai = 0; ai < 2; ai++) {
+                s.color = graphics_rgba(90, 200, 120, alphas[ai]);
+                s.rect = graphics_rect(200, 200, dirs[d].dx * length, dirs[d].dy * length);
+                snprintf(name, sizeof(name), "draw_line/%d/%s/a%d", length, dirs[d].name, alphas[ai]);
+                bench_run(name, run_draw_line, &s, length);
+            }
+        }
+    }
+    
+    /* Text */
+    static const char* texts[] = {
+        "Hello, benchmark",
+        "The quick brown fox jumps over the lazy dog. The quick brown fox jumps over the lazy dog. 0123456789 !?",
+    };
+    for (i32 t = 0; t < 2; t++) {
+        for (i32 ai = 0; ai < 2; ai++) {
+            i32 w, h;
+            s.text = texts[t];
+            s.color = graphics_rgba(240, 240, 240, alphas[ai]);
+            s.rect = graphics_rect(100, 300, 0, 0);
+            graphics_measure_text(s.text, NULL, &w, &h);
+            snprintf(name, sizeof(name), "draw_text/%dch/a%d", (i32)strlen(s.text), alphas[ai]);
+            bench_run(name, run_draw_text, &s, (f64)w * h);
+        }
+    }
+    
+    /* Image blits and scaled blits by image opacity */
+    static const struct { const char* name; graphics_opacity_t opacity; } kinds[] = {
+        { "opaque", GRAPHICS_OPACITY_OPAQUE }, { "binary", GRAPHICS_OPACITY_BINARY }, { "alpha", GRAPHICS_OPACITY_ALPHA },
+    };
+    for (i32 k = 0; k < 3; k++) {
+        for (i32 si = 0; si < 3; si++) {
+            i32 size = sizes[si];
+            s.image = make_image(size, kinds[k].opacity);
+            for (i32 clip = CLIP_NONE; clip <= CLIP_EDGE; clip++) {
+                place_shape(&s, size, (clip_mode_t)clip, false);
+                snprintf(name, sizeof(name), "draw_image/%d/%s/%s", size, kinds[k].name, g_clip_names[clip]);
+                bench_run(name, run_draw_image, &s, (f64)size * size * clip_share((clip_mode_t)clip));
+            }
+            graphics_clear_clip_rect(ctx);
+            
+            /* Scale up 2x and down 2x */
+            for (i32 dir = 0; dir < 2; dir++) {
+                i32 dest = dir == 0 ? size * 2 : size / 2;
+                for (i32 f = 0; f < 2; f++) {
+                    s.filter = f == 0 ? GRAPHICS_FILTER_NEAREST : GRAPHICS_FILTER_BILINEAR;
+                    s.rect = graphics_rect(300, 200, dest, dest);
+                    snprintf(name, sizeof(name), "draw_image_scaled/%d-%d/%s/%s", size, dest, kinds[k].name,
+                             f == 0 ? "nearest" : "bilinear");
+                    bench_run(name, run_draw_image_scaled, &s, (f64)dest * dest);
+                }
+            }
+            graphics_destroy_image(s.image);
+            s.image = NULL;
+        }
+    }
+}
+
+/* Present conversion into a headless window (32bpp BGRX) */
+static void bench_present(void) {
+    static const i32 sizes[][2] = { { 640, 480 }, { 1280, 720 }, { BENCH_WIDTH, BENCH_HEIGHT } };
+    char name[96];
+    
+    for (i32 i = 0; i < 3; i++) {
+        prim_state_t s;
+        memset(&s, 0, sizeof(s));
+        s.frame_width = sizes[i][0];
+        s.frame_height = sizes[i][1];
+        
+        platform_window_config_t config = {
+            .title = "graphics_bench",
+            .width = s.frame_width,
+            .height = s.frame_height,
+            .x = -1,
+            .y = -1,
+            .visible = true,
+        };
+        if (platform_window_create(&config, &s.window) != ENGINE_SUCCESS) continue;
+        
+        graphics_context_t* frame = graphics_create_context(s.frame_width, s.frame_height);
+        graphics_clear(frame, graphics_rgb(30, 60, 90));
+        s.frame = graphics_get_pixels(frame);
+        
+        s.present_rect = (platform_rect_t){ 0, 0, s.frame_width, s.frame_height };
+        snprintf(name, sizeof(name), "present/%dx%d/full", s.frame_width, s.frame_height);
+        bench_run(name, run_present, &s, (f64)s.frame_width * s.frame_height);
+        
+        s.present_rect = (platform_rect_t){ s.frame_width / 4, s.frame_height / 4, 200, 100 };
+        snprintf(name, sizeof(name), "present/%dx%d/rect200x100", s.frame_width, s.frame_height);
+        bench_run(name, run_present, &s, 200.0 * 100.0);
+        
+        graphics_destroy_context(frame);
+        platform_window_destroy(s.window);
+    }
+}
+
+/* Full-frame scenes */
+typedef struct {
+    graphics_context_t* gfx;
+    ui_context_t* ui;
+    window_manager_t* wm;
+    window_t* windows[3];
+    
+    /* ui_demo widget state */
+    bool checkbox[3];
+    i32 radio_option;
+    i32 slider_int_value;
+    f32 slider_float_value;
+    i32 selected_theme;
+    char text_buffer[128];
+} scene_state_t;
+
+/* The ui_demo frame */
+static void run_scene_ui_demo(void* p, i32 i) {
+    scene_state_t* s = (scene_state_t*)p;
+    f32 time = (f32)i / 60.0f;
+    char info[256];
+    
+    graphics_clear(s->gfx, graphics_rgb(30, 30, 35));
+    ui_begin_frame(s->ui);
+    
+    if (ui_begin_menu_bar(s->ui)) {
+        if (ui_begin_menu(s->ui, "File")) {
+            ui_menu_item(s->ui, "New");
+            ui_menu_item(s->ui, "Open");
+            ui_menu_item(s->ui, "Save");
+            ui_end_menu(s->ui);
+        }
+        if (ui_begin_menu(s->ui, "Edit")) {
+            ui_menu_item(s->ui, "Cut");
+            ui_menu_item(s->ui, "Copy");
+            ui_menu_item(s->ui, "Paste");
+            ui_end_menu(s->ui);
+        }
+        ui_end_menu_bar(s->ui);
+    }
+    
+    if (ui_begin_window(s->ui, "UI Demo Application", 20, 60, 980, 680)) {
+        static const char* options[] = { "Dark Theme", "Light Theme", "Blue Theme", "Red Theme" };
+        
+        ui_label_ex(s->ui, "2D Engine - UI Widget Showcase", UI_ALIGN_CENTER);
+        ui_separator(s->ui);
+        ui_spacing(s->ui, 10);
+        ui_label(s->ui, "Dropdown:");
+        ui_dropdown(s->ui, "ThemeSelect", options, 4, &s->selected_theme);
+        ui_separator(s->ui);
+        
+        ui_label(s->ui, "Buttons:");
+        ui_button(s->ui, "Click Me!");
+        ui_same_line(s->ui);
+        ui_button(s->ui, "Another Button");
+        ui_same_line(s->ui);
+        ui_button_ex(s->ui, "Wide Button", 250, 24);
+        ui_separator(s->ui);
+        
+        ui_label(s->ui, "Checkboxes:");
+        ui_checkbox(s->ui, "Enable feature A", &s->checkbox[0]);
+        ui_checkbox(s->ui, "Enable feature B", &s->checkbox[1]);
+        ui_checkbox(s->ui, "Enable feature C", &s->checkbox[2]);
+        ui_separator(s->ui);
+        
+        ui_label(s->ui, "Radio Buttons (Select one):");
+        ui_radio(s->ui, "Option 1", &s->radio_option, 0);
+        ui_radio(s->ui, "Option 2", &s->radio_option, 1);
+        ui_radio(s->ui, "Option 3", &s->radio_option, 2);
+        ui_separator(s->ui);
+        
+        ui_label(s->ui, "Sliders:");
+        ui_slider_int(s->ui, "Integer", &s->slider_int_value, 0, 100);
+        ui_slider_float(s->ui, "Float", &s->slider_float_value, 0.0f, 1.0f);
+        ui_separator(s->ui);
+        
+        ui_label(s->ui, "Text Input:");
+        ui_text_input(s->ui, "Name", s->text_buffer, sizeof(s->text_buffer));
+        ui_separator(s->ui);
+        
+        ui_label(s->ui, "Progress Bar (Animated):");
+        ui_progress_bar(s->ui, (sinf(time) + 1.0f) * 0.5f);
+        ui_separator(s->ui);
+        
+        snprintf(info, sizeof(info), "Time: %.2fs  |  FPS: ~60", time);
+        ui_label_ex(s->ui, info, UI_ALIGN_CENTER);
+        ui_end_window(s->ui);
+    }
+    
+    ui_end_frame(s->ui);
+}
+
+/* The window_demo frame */
+static void run_scene_window_demo(void* p, i32 i) {
+    scene_state_t* s = (scene_state_t*)p;
+    char text[64];
+    
+    graphics_clear(s->gfx, graphics_rgb(40, 40, 45));
+    ui_begin_frame(s->ui);
+    window_manager_update(s->wm, 0, 0, false, false);
+    window_manager_render(s->wm, s->gfx, NULL);
+    
+    if (window_begin(s->wm, s->windows[0])) {
+        ui_label(s->ui, "Welcome to the Window Manager Demo!");
+        ui_spacing(s->ui, 10);
+        ui_label(s->ui, "You can:");
+        ui_label(s->ui, "- Drag windows by their title bars");
+        ui_label(s->ui, "- Resize windows by dragging the corner");
+        ui_label(s->ui, "- Close windows with the X button");
+        ui_label(s->ui, "- Click windows to bring them to front");
+        window_end(s->wm, s->windows[0]);
+    }
+    
+    if (window_begin(s->wm, s->windows[1])) {
+        ui_label(s->ui, "Settings Panel");
+        ui_separator(s->ui);
+        ui_checkbox(s->ui, "Enable Feature A", &s->checkbox[0]);
+        ui_checkbox(s->ui, "Enable Feature B", &s->checkbox[1]);
+        ui_spacing(s->ui, 10);
+        ui_button(s->ui, "Apply Settings");
+        window_end(s->wm, s->windows[1]);
+    }
+    
+    if (window_begin(s->wm, s->windows[2])) {
+        ui_label(s->ui, "System Information");
+        ui_separator(s->ui);
+        ui_label(s->ui, "FPS: ~60");
+        snprintf(text, sizeof(text), "Time: %.1f seconds", (f32)i / 60.0f);
+        ui_label(s->ui, text);
+        window_end(s->wm, s->windows[2]);
+    }
+    
+    ui_end_frame(s->ui);
+}
+
+static void bench_scenes(void) {
+    scene_state_t s;
+    memset(&s, 0, sizeof(s));
+    s.gfx = graphics_create_context(1024, 768);
+    s.ui = ui_create_context(s.gfx);
+    s.wm = window_manager_create();
+    if (!s.gfx || !s.ui || !s.wm) {
+        fprintf(stderr, "Failed to create scene contexts\n");
+        return;
+    }
+    
+    s.checkbox[0] = true;
+    s.slider_int_value = 50;
+    s.slider_float_value = 0.5f;
+    strcpy(s.text_buffer, "Hello UI!");
+    bench_run("scene/ui_demo/1024x768", run_scene_ui_demo, &s, 1024.0 * 768.0);
+    
+    s.windows[0] = window_create(s.wm, "Welcome Window", 100, 100, 400, 300);
+    s.windows[1] = window_create(s.wm, "Settings", 520, 150, 350, 250);
+    s.windows[2] = window_create(s.wm, "Info Panel", 250, 420, 500, 200);
+    bench_run("scene/window_demo/1024x768", run_scene_window_demo, &s, 1024.0 * 768.0);
+    
+    window_manager_destroy(s.wm);
+    ui_destroy_context(s.ui);
+    graphics_destroy_context(s.gfx);
+}
+
+int main(int argc, char** argv) {
+    const char* out_path = NULL;
+    const char* compare_path = NULL;
+    
+    for (i32 i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            g_bench.min_time = 0.02;
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            g_bench.filter = argv[++i];
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+            compare_path = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            g_bench.threshold = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--filter TEXT] [--out FILE] [--compare FILE] [--threshold PERCENT]\n", argv[0]);
+            return 2;
+        }
+    }
+    
+    if (compare_path && !load_baseline(compare_path)) return 2;
+    if (out_path) {
+        g_bench.out = fopen(out_path, "w");
+        if (!g_bench.out) {
+            fprintf(stderr, "Failed to create %s\n", out_path);
+            return 2;
+        }
+        fprintf(g_bench.out, "name,iterations,ns_per_call,mpix_per_s\n");
+    }
+    
+    platform_set_headless(NULL);
+    engine_config_t config = { .app_name = "graphics_bench", .enable_logging = false };
+    if (engine_init(&config) != ENGINE_SUCCESS) {
+        fprintf(stderr, "Failed to initialize engine\n");
+        return 1;
+    }
+
+#ifdef ENGINE_DEBUG
+    printf("Note: debug build, numbers are unoptimized. Use make bench DEBUG=0.\n");
+#endif
+
+    graphics_context_t* ctx = graphics_create_context(BENCH_WIDTH, BENCH_HEIGHT);
+    graphics_clear(ctx, graphics_rgb(20, 20, 20));
+    bench_primitives(ctx);
+    graphics_destroy_context(ctx);
+    
+    bench_present();
+    bench_scenes();
+    
+    engine_shutdown();
+    if (g_bench.out) {
+        fclose(g_bench.out);
+        printf("Wrote %d results to %s\n", g_bench.cases, out_path);
+    }
+    if (compare_path) {
+        printf("%d of %d cases more than %.0f%% slower than %s\n", g_bench.regressions, g_bench.cases,
+               g_bench.threshold, compare_path);
+    }
+    free(g_bench.baseline);
+    return g_bench.regressions > 0 ? 1 : 0;
+}
@@ -150,9 +150,7 @@ int main(void) {
         if (ui_begin_window(ui, "Audio Control Panel", 50, 50, 700, 400)) {
             ui_label(ui, "Sound Effect Channel");
             
-            char sfx_label[300];
-            snprintf(sfx_label, sizeof(sfx_label), "Current File: %s", sfx_path);
-            ui_label(ui, sfx_label);
+            ui_label(ui, frame_arena_printf(ui_get_frame_arena(ui), "Current File: %s", sfx_path));
             
             if (ui_button(ui, "Load SFX...")) {
                 char* path = dialog_open_file("Load Sound Effect", NULL, audio_filters, 1);
@@ -176,9 +174,7 @@ int main(void) {
             
             ui_label(ui, "Music Channel");
             
-            char music_label[300];
-            snprintf(music_label, sizeof(music_label), "Current File: %s", music_path);
-            ui_label(ui, music_label);
+            ui_label(ui, frame_arena_printf(ui_get_frame_arena(ui), "Current File: %s", music_path));
             
             if (ui_button(ui, "Load Music...")) {
                 char* path = dialog_open_file("Load Music Track", NULL, audio_filters, 1);
@@ -239,7 +235,7 @@ int main(void) {
         platform_window_present_buffer((platform_window_t*)win_internal->platform_window,
                                      graphics_get_pixels(gfx), 800, 500);
         
-        platform_sleep(16);
+        engine_wait_frame();
     }
     
     printf("\nCleaning up...\n");
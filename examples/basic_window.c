@@ -86,7 +86,10 @@ int main(void) {
         frame_count++;
         double current_time = engine_get_time();
         if (current_time - last_time >= 1.0) {
-            printf("FPS: %d\n", frame_count);
+            engine_frame_stats_t stats;
+            engine_get_frame_stats(&stats);
+            printf("FPS: %d (p50 %.1f ms, p99 %.1f ms, max %.1f ms, %d missed)\n",
+                   frame_count, stats.p50_ms, stats.p99_ms, stats.max_ms, stats.missed);
             frame_count = 0;
             last_time = current_time;
         }
@@ -96,6 +99,9 @@ int main(void) {
          * 2. Render graphics
          * 3. Swap buffers
          */
+        
+        /* Pace to 60 FPS */
+        engine_wait_frame();
     }
     
     /* Cleanup */
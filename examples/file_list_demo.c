@@ -199,8 +199,8 @@ int main(void) {
             600
         );
         
-        /* Small sleep to limit FPS */
-        platform_sleep(16);
+        /* Pace to 60 FPS */
+        engine_wait_frame();
     }
     
     ui_destroy_context(ui);
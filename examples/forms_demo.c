@@ -262,7 +262,7 @@ int main(void) {
         platform_window_present_buffer((platform_window_t*)win_internal->platform_window,
                                      graphics_get_pixels(state.gfx), width, height);
         
-        platform_sleep(16);
+        engine_wait_frame();
     }
     
     printf("\nCleaning up...\n");
@@ -194,8 +194,8 @@ int main(void) {
             height
         );
         
-        /* Cap frame rate to ~60 FPS */
-        platform_sleep(16);
+        /* Pace to 60 FPS */
+        engine_wait_frame();
     }
     
     /* Cleanup */
@@ -278,7 +278,7 @@ int main(void) {
             width, height
         );
         
-        platform_sleep(16);  /* ~60 FPS */
+        engine_wait_frame();  /* 60 FPS */
     }
     
     /* Cleanup */
@@ -66,7 +66,7 @@ int main(void) {
             break;
         }
         
-        platform_sleep(16);
+        engine_wait_frame();
     }
     
     engine_window_destroy(window);
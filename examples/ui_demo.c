@@ -309,7 +309,7 @@ int main(void) {
             graphics_get_height(state.gfx)
         );
         
-        platform_sleep(16); /* ~60 FPS */
+        engine_wait_frame(); /* 60 FPS */
     }
     
     /* Cleanup */
@@ -197,7 +197,7 @@ int main(void) {
         platform_window_present_buffer(plat_window, graphics_get_pixels(state.gfx), 
                                       graphics_get_width(state.gfx), graphics_get_height(state.gfx));
         
-        platform_sleep(16);
+        engine_wait_frame();
     }
     
     /* Cleanup */
@@ -0,0 +1,32 @@
+#ifndef ENGINE_ARENA_H
+#define ENGINE_ARENA_H
+
+#include "types.h"
+
+/* Forward declaration */
+typedef struct frame_arena frame_arena_t;
+
+/* Frame arena
+ * A bump allocator for data that lives for a frame or two. It has two
+ * halves: allocations come from the current one, and frame_arena_swap
+ * switches halves and resets the one it switches to. Memory allocated
+ * during a frame therefore stays valid through the next frame and is
+ * reclaimed at the swap after that, without any frees. A half that runs
+ * out takes extra blocks from malloc, and on its next reset is replaced by
+ * one block big enough for the whole frame, so steady state allocates
+ * nothing. Not thread-safe; use one arena per thread. */
+ENGINE_API frame_arena_t* frame_arena_create(size_t capacity);  /* Bytes per half, 0 picks 64 KiB */
+ENGINE_API void frame_arena_destroy(frame_arena_t* arena);
+ENGINE_API void frame_arena_swap(frame_arena_t* arena);
+
+/* Allocation; NULL only when malloc fails. frame_arena_alloc aligns to 16. */
+ENGINE_API void* frame_arena_alloc(frame_arena_t* arena, size_t size);
+ENGINE_API void* frame_arena_alloc_aligned(frame_arena_t* arena, size_t size, size_t alignment);
+ENGINE_API char* frame_arena_strdup(frame_arena_t* arena, const char* str);
+ENGINE_API char* frame_arena_printf(frame_arena_t* arena, const char* format, ...);
+
+/* Statistics */
+ENGINE_API size_t frame_arena_get_used(const frame_arena_t* arena);      /* This frame so far */
+ENGINE_API size_t frame_arena_get_capacity(const frame_arena_t* arena);  /* Both halves */
+
+#endif /* ENGINE_ARENA_H */
@@ -0,0 +1,84 @@
+#ifndef ENGINE_ASSETS_H
+#define ENGINE_ASSETS_H
+
+#include "types.h"
+#include "graphics.h"
+#include "audio.h"
+
+/* Forward declaration */
+typedef struct asset_request asset_request_t;
+
+/* Asset kinds the loader threads know how to load */
+typedef enum {
+    ASSET_TYPE_IMAGE = 0,
+    ASSET_TYPE_SOUND,
+} asset_type_t;
+
+/* Request lifecycle */
+typedef enum {
+    ASSET_STATE_PENDING = 0,  /* Queued, not started */
+    ASSET_STATE_LOADING,      /* A loader thread is reading it */
+    ASSET_STATE_READY,        /* Loaded, the asset can be fetched */
+    ASSET_STATE_FAILED,       /* Load failed or was cancelled at shutdown */
+} asset_state_t;
+
+/* Pending requests start highest priority first, then in request order */
+typedef enum {
+    ASSET_PRIORITY_LOW = 0,
+    ASSET_PRIORITY_NORMAL,
+    ASSET_PRIORITY_HIGH,
+    ASSET_PRIORITY_CRITICAL,
+} asset_priority_t;
+
+/* Completion callback, run from assets_update on the thread that calls it */
+typedef void (*asset_callback_t)(asset_request_t* request, void* user_data);
+
+/* Asset system initialization
+ * thread_count loader threads are started (0 picks a default). */
+ENGINE_API engine_result_t assets_init(i32 thread_count);
+ENGINE_API void assets_shutdown(void);
+
+/* Run completion callbacks for requests finished since the last call */
+ENGINE_API void assets_update(void);
+ENGINE_API i32 assets_get_pending_count(void);  /* Requests not yet finished */
+
+/* Asynchronous loading
+ * Each call returns a handle the caller must release. Requests for the same
+ * path share one load and one asset: a request for a path still in flight
+ * joins it (raising its priority if it asks for more), and a request for a
+ * resident path is ready at once. callback may be NULL. */
+ENGINE_API asset_request_t* assets_load_image(const char* path, asset_priority_t priority, asset_callback_t callback, void* user_data);
+ENGINE_API asset_request_t* assets_load_sound(const char* path, asset_priority_t priority, asset_callback_t callback, void* user_data);
+
+/* Release a handle. With the last handle gone a loaded asset stays cached
+ * until the cache budget needs its memory. */
+ENGINE_API void asset_request_release(asset_request_t* request);
+
+/* Request queries, safe to poll every frame */
+ENGINE_API asset_state_t asset_request_get_state(const asset_request_t* request);
+ENGINE_API bool asset_request_is_done(const asset_request_t* request);  /* Ready or failed */
+ENGINE_API void asset_request_wait(asset_request_t* request);           /* Block until done */
+ENGINE_API const char* asset_request_get_path(const asset_request_t* request);
+
+/* Loaded asset, NULL unless the request is ready or the type differs */
+ENGINE_API graphics_image_t* asset_request_get_image(const asset_request_t* request);
+ENGINE_API audio_sound_t* asset_request_get_sound(const asset_request_t* request);
+
+/* Cache statistics */
+typedef struct {
+    u64 hits;               /* Requests served by a resident or in-flight entry */
+    u64 misses;             /* Requests that started a load */
+    size_t bytes_resident;  /* Loaded assets, referenced or not */
+    size_t bytes_budget;
+    i32 entries;            /* Loaded or in flight */
+    i32 unreferenced;       /* Held only by the cache, evicted least recently used first */
+} asset_cache_stats_t;
+
+/* Cache control
+ * Only unreferenced entries are evicted, so referenced assets may exceed
+ * the budget (64 MiB by default). */
+ENGINE_API void assets_set_cache_budget(size_t bytes);
+ENGINE_API void assets_trim_cache(void);  /* Evict every unreferenced entry */
+ENGINE_API void assets_get_cache_stats(asset_cache_stats_t* out_stats);
+
+#endif /* ENGINE_ASSETS_H */
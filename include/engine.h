@@ -6,6 +6,11 @@
 #include "ui.h"
 #include "input.h"
 #include "audio.h"
+#include "assets.h"
+#include "profiler.h"
+#include "simulation.h"
+#include "jobs.h"
+#include "arena.h"
 #include "dialogs.h"
 
 /* Engine configuration */
@@ -30,6 +35,7 @@ typedef struct {
 typedef struct {
     const char* app_name;
     bool enable_logging;
+    i32 job_workers;  /* Job system workers: 0 for one per extra CPU core, negative for none */
 } engine_config_t;
 
 /**
@@ -101,6 +107,28 @@ ENGINE_API void engine_window_set_title(engine_window_t* window, const char* tit
  */
 ENGINE_API void engine_window_set_visible(engine_window_t* window, bool visible);
 
+/**
+ * Present the damaged area of a graphics context to the window
+ * Only rects reported by graphics_get_damage are converted and copied,
+ * then the context's damage is reset. An undamaged context costs nothing.
+ * @param window Window to present to
+ * @param gfx Graphics context holding the frame
+ */
+ENGINE_API void engine_window_present(engine_window_t* window, graphics_context_t* gfx);
+
+/**
+ * Get a graphics context that draws straight into the window's back page
+ * Available on 32bpp BGRX framebuffers that can flip between two pages.
+ * The context uses GRAPHICS_FORMAT_BGRA (load images in that format to
+ * skip conversion), and presenting it flips pages instead of copying. After
+ * a flip the next back page holds the frame before last, so redraw it in
+ * full. Returns NULL when unsupported; render to an ordinary context and
+ * present that instead.
+ * @param window Window to draw to
+ * @return Context for the next frame, owned by the window
+ */
+ENGINE_API graphics_context_t* engine_window_get_direct_context(engine_window_t* window);
+
 /**
  * Get engine version string
  * @return Version string in format "major.minor.patch"
@@ -119,4 +147,58 @@ ENGINE_API const char* engine_get_platform(void);
  */
 ENGINE_API f64 engine_get_time(void);
 
+/* Frame-time statistics over the last ENGINE_FRAME_STATS_WINDOW frames */
+#define ENGINE_FRAME_STATS_WINDOW 512
+
+typedef struct {
+    f64 target_ms;    /* Frame period being paced to, 0 when unpaced */
+    f64 avg_ms;
+    f64 p50_ms;
+    f64 p95_ms;
+    f64 p99_ms;
+    f64 max_ms;
+    i32 frames;       /* Frames in the window */
+    i32 missed;       /* Frames in the window that overran their deadline */
+    u64 total_frames; /* Since initialization or the last reset */
+    u64 total_missed;
+} engine_frame_stats_t;
+
+/**
+ * Set the frame rate engine_wait_frame paces to
+ * The default is 60. Pass 0 to stop pacing; frames are still timed.
+ * May be called before engine_init, which keeps the setting.
+ * @param fps Frames per second
+ */
+ENGINE_API void engine_set_target_fps(f64 fps);
+
+/**
+ * End the frame: wait for its deadline and record its duration
+ * Call once per frame, after presenting. The wait sleeps until just before
+ * the deadline and spins the rest of the way. A frame that is already past
+ * its deadline counts as missed and does not wait; after a long stall the
+ * schedule restarts from now rather than rushing to catch up.
+ * @return Seconds since the previous call (0 on the first call)
+ */
+ENGINE_API f64 engine_wait_frame(void);
+
+/**
+ * Get the engine's frame arena
+ * engine_wait_frame swaps it, so allocations stay valid until the
+ * engine_wait_frame after next. For the main thread only.
+ * @return The arena, or NULL before engine_init
+ */
+ENGINE_API frame_arena_t* engine_get_frame_arena(void);
+
+/**
+ * Get frame-time statistics
+ * Percentiles are read from a histogram with 0.1 ms buckets.
+ * @param out_stats Receives the statistics
+ */
+ENGINE_API void engine_get_frame_stats(engine_frame_stats_t* out_stats);
+
+/**
+ * Clear the frame-time statistics
+ */
+ENGINE_API void engine_reset_frame_stats(void);
+
 #endif /* ENGINE_H */
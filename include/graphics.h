@@ -7,6 +7,8 @@
 typedef struct graphics_context graphics_context_t;
 typedef struct graphics_image graphics_image_t;
 typedef struct graphics_font graphics_font_t;
+typedef struct graphics_display_list graphics_display_list_t;
+typedef struct graphics_atlas graphics_atlas_t;
 
 /* Color structure (RGBA) */
 typedef struct {
@@ -24,6 +26,43 @@ typedef struct {
     i32 x, y;
 } graphics_point_t;
 
+/* Vertex for the sub-pixel triangle rasterizer */
+typedef struct {
+    f32 x, y;
+    graphics_color_t color;
+} graphics_vertex_t;
+
+/* Triangle rasterizer flags */
+typedef enum {
+    GRAPHICS_TRIANGLE_FLAT    = 0,       /* Fill with the first vertex color */
+    GRAPHICS_TRIANGLE_GOURAUD = 1 << 0,  /* Interpolate the vertex colors */
+} graphics_triangle_flags_t;
+
+/* Image opacity, classified when an image is loaded */
+typedef enum {
+    GRAPHICS_OPACITY_OPAQUE = 0,  /* Every pixel has alpha 255 */
+    GRAPHICS_OPACITY_BINARY,      /* Alpha is only ever 0 or 255 */
+    GRAPHICS_OPACITY_ALPHA,       /* Some pixels are translucent */
+} graphics_opacity_t;
+
+/* Pixel formats
+ * Straight RGBA blends leave destination alpha at 255. Premultiplied RGBA
+ * stores color scaled by alpha and composes alpha too, so translucent
+ * layers can be cached and stacked. BGRA is straight alpha with red and
+ * blue swapped, the native layout of 32bpp framebuffers. Colors passed to
+ * draw calls are always straight RGBA; contexts convert them. */
+typedef enum {
+    GRAPHICS_FORMAT_RGBA = 0,
+    GRAPHICS_FORMAT_PREMULTIPLIED,
+    GRAPHICS_FORMAT_BGRA,
+} graphics_format_t;
+
+/* Image scaling filters */
+typedef enum {
+    GRAPHICS_FILTER_NEAREST = 0,  /* Fastest, blocky */
+    GRAPHICS_FILTER_BILINEAR,     /* Smooth; large downscales use mipmaps */
+} graphics_filter_t;
+
 /* Predefined colors */
 #define COLOR_BLACK       ((graphics_color_t){0, 0, 0, 255})
 #define COLOR_WHITE       ((graphics_color_t){255, 255, 255, 255})
@@ -46,7 +85,56 @@ ENGINE_API graphics_context_t* graphics_create_context(i32 width, i32 height);
 ENGINE_API void graphics_destroy_context(graphics_context_t* ctx);
 ENGINE_API i32 graphics_get_width(const graphics_context_t* ctx);
 ENGINE_API i32 graphics_get_height(const graphics_context_t* ctx);
+ENGINE_API i32 graphics_get_pitch(const graphics_context_t* ctx);  /* Bytes from one row to the next */
 ENGINE_API void graphics_resize(graphics_context_t* ctx, i32 width, i32 height);
+ENGINE_API void graphics_set_format(graphics_context_t* ctx, graphics_format_t format);  /* Converts existing pixels */
+ENGINE_API graphics_format_t graphics_get_format(const graphics_context_t* ctx);
+
+/* Views
+ * Contexts that draw into pixels they do not own, without copying. A view
+ * aliases a rect of a context or image (NULL for all of it) and must be
+ * destroyed first; damage drawn through a context view is added to its
+ * parent, and commands the parent has deferred are flushed before the view
+ * writes. Drawing into an image reclassifies it as translucent. Wrapped
+ * buffers take their pitch in bytes. Views cannot be resized. */
+ENGINE_API graphics_context_t* graphics_create_context_from_pixels(u32* pixels, i32 width, i32 height, i32 pitch);
+ENGINE_API graphics_context_t* graphics_create_view(graphics_context_t* parent, const graphics_rect_t* rect);
+ENGINE_API graphics_context_t* graphics_create_image_view(graphics_image_t* image, const graphics_rect_t* rect);
+
+/* Damage tracking
+ * Contexts accumulate the area touched by draw calls as at most
+ * GRAPHICS_MAX_DAMAGE_RECTS merged rects. Present only those rects, then
+ * reset. Writes made through graphics_get_pixels must be added by hand. */
+#define GRAPHICS_MAX_DAMAGE_RECTS 16
+ENGINE_API i32 graphics_get_damage(const graphics_context_t* ctx, const graphics_rect_t** out_rects);
+ENGINE_API void graphics_add_damage(graphics_context_t* ctx, const graphics_rect_t* rect);
+ENGINE_API void graphics_reset_damage(graphics_context_t* ctx);
+
+/* Deferred rendering
+ * Between begin and end, draw calls are recorded and rasterized in parallel,
+ * one screen tile per task, when graphics_flush is called (or implicitly by
+ * graphics_get_pixels). Output matches immediate mode exactly. Images passed
+ * to draw calls must stay alive until the next flush. Tiles run on the job
+ * system's workers when it has any, else on threads of graphics' own (see
+ * graphics_set_render_threads). */
+ENGINE_API void graphics_begin_deferred(graphics_context_t* ctx);
+ENGINE_API void graphics_end_deferred(graphics_context_t* ctx);
+ENGINE_API void graphics_flush(graphics_context_t* ctx);
+ENGINE_API bool graphics_is_deferred(const graphics_context_t* ctx);
+ENGINE_API void graphics_set_render_threads(i32 count);  /* 0 = one per extra CPU core */
+
+/* Display lists
+ * Draw calls made on ctx between begin and end are recorded into the list
+ * instead of drawn. Ending the recording merges compatible commands. A list
+ * can be replayed into any context any number of times once recording has
+ * ended; commands keep the clip that was active when they were recorded. */
+ENGINE_API graphics_display_list_t* graphics_display_list_create(void);
+ENGINE_API void graphics_display_list_destroy(graphics_display_list_t* list);
+ENGINE_API void graphics_display_list_reset(graphics_display_list_t* list);
+ENGINE_API i32 graphics_display_list_get_count(const graphics_display_list_t* list);
+ENGINE_API void graphics_begin_record(graphics_context_t* ctx, graphics_display_list_t* list);
+ENGINE_API void graphics_end_record(graphics_context_t* ctx);
+ENGINE_API void graphics_display_list_replay(const graphics_display_list_t* list, graphics_context_t* ctx);
 
 /* Rendering control */
 ENGINE_API void graphics_clear(graphics_context_t* ctx, graphics_color_t color);
@@ -63,21 +151,58 @@ ENGINE_API void graphics_fill_circle(graphics_context_t* ctx, i32 cx, i32 cy, i3
 ENGINE_API void graphics_draw_triangle(graphics_context_t* ctx, i32 x1, i32 y1, i32 x2, i32 y2, i32 x3, i32 y3, graphics_color_t color);
 ENGINE_API void graphics_fill_triangle(graphics_context_t* ctx, i32 x1, i32 y1, i32 x2, i32 y2, i32 x3, i32 y3, graphics_color_t color);
 
+/* Sub-pixel triangles with a top-left fill rule: adjacent triangles share edges without overlap or gaps */
+ENGINE_API void graphics_fill_triangle_ex(graphics_context_t* ctx, const graphics_vertex_t* v1, const graphics_vertex_t* v2, const graphics_vertex_t* v3, u32 flags);
+ENGINE_API void graphics_fill_triangles(graphics_context_t* ctx, const graphics_vertex_t* vertices, i32 vertex_count, u32 flags);
+
 /* Text rendering */
 ENGINE_API graphics_font_t* graphics_get_default_font(void);
 ENGINE_API void graphics_draw_text(graphics_context_t* ctx, const char* text, i32 x, i32 y, graphics_color_t color, graphics_font_t* font);
 ENGINE_API void graphics_measure_text(const char* text, graphics_font_t* font, i32* out_width, i32* out_height);
 
 /* Image operations */
-ENGINE_API graphics_image_t* graphics_load_image(const char* filename);
+ENGINE_API graphics_image_t* graphics_load_image(const char* filename);  /* BMP (24/32-bit) or QOI */
+ENGINE_API graphics_image_t* graphics_load_image_ex(const char* filename, graphics_format_t format);
+ENGINE_API bool graphics_save_image_qoi(const graphics_image_t* image, const char* filename);
+ENGINE_API bool graphics_save_pixels_qoi(const u32* pixels, i32 width, i32 height, i32 pitch, graphics_format_t format, const char* filename);  /* pitch in bytes */
 ENGINE_API graphics_image_t* graphics_create_image(i32 width, i32 height);
 ENGINE_API void graphics_destroy_image(graphics_image_t* image);
 ENGINE_API void graphics_draw_image(graphics_context_t* ctx, const graphics_image_t* image, i32 x, i32 y);
 ENGINE_API void graphics_draw_image_scaled(graphics_context_t* ctx, const graphics_image_t* image, const graphics_rect_t* dest);
+ENGINE_API void graphics_draw_image_scaled_ex(graphics_context_t* ctx, const graphics_image_t* image, const graphics_rect_t* dest, graphics_filter_t filter);
+ENGINE_API void graphics_image_set_format(graphics_image_t* image, graphics_format_t format);  /* Converts pixels */
+ENGINE_API graphics_format_t graphics_image_get_format(const graphics_image_t* image);
+ENGINE_API graphics_opacity_t graphics_image_get_opacity(const graphics_image_t* image);
+
+/* Sprite atlases
+ * Images are packed into one atlas page and drawn by handle. Batches are
+ * drawn in atlas order rather than array order, so only batch sprites whose
+ * overlap order does not matter. The atlas must outlive deferred draws. */
+typedef i32 graphics_sprite_t;
+#define GRAPHICS_SPRITE_NONE (-1)
+
+typedef struct {
+    graphics_sprite_t sprite;
+    i32 x, y;
+} graphics_sprite_draw_t;
+
+ENGINE_API graphics_atlas_t* graphics_atlas_create(i32 width, i32 height, graphics_format_t format);
+ENGINE_API void graphics_atlas_destroy(graphics_atlas_t* atlas);
+ENGINE_API graphics_sprite_t graphics_atlas_add(graphics_atlas_t* atlas, const graphics_image_t* image);
+ENGINE_API i32 graphics_atlas_pack(graphics_atlas_t* atlas, const graphics_image_t* const* images, i32 count, graphics_sprite_t* out_sprites);  /* Returns how many fit */
+ENGINE_API const graphics_image_t* graphics_atlas_get_image(const graphics_atlas_t* atlas);
+ENGINE_API graphics_rect_t graphics_atlas_get_rect(const graphics_atlas_t* atlas, graphics_sprite_t sprite);
+ENGINE_API void graphics_draw_sprite(graphics_context_t* ctx, const graphics_atlas_t* atlas, graphics_sprite_t sprite, i32 x, i32 y);
+ENGINE_API void graphics_draw_sprites(graphics_context_t* ctx, const graphics_atlas_t* atlas, const graphics_sprite_draw_t* sprites, i32 count);
+
+/* Composite another context onto ctx at (x, y), converting formats if they differ.
+ * In deferred mode the layer must not be drawn to until ctx is flushed. */
+ENGINE_API void graphics_draw_layer(graphics_context_t* ctx, graphics_context_t* layer, i32 x, i32 y);
 ENGINE_API i32 graphics_image_get_width(const graphics_image_t* image);
 ENGINE_API i32 graphics_image_get_height(const graphics_image_t* image);
 
-/* Direct pixel buffer access (for advanced usage) */
+/* Direct pixel buffer access (for advanced usage)
+ * Rows are graphics_get_pitch bytes apart. set_pixels takes tightly packed rows. */
 ENGINE_API u32* graphics_get_pixels(graphics_context_t* ctx);
 ENGINE_API void graphics_set_pixels(graphics_context_t* ctx, const u32* pixels);
 
@@ -0,0 +1,54 @@
+#ifndef ENGINE_JOBS_H
+#define ENGINE_JOBS_H
+
+#include "types.h"
+
+#define JOBS_MAX_WORKERS 32
+
+/* A unit of work */
+typedef void (*job_fn_t)(void* data);
+
+typedef struct {
+    job_fn_t fn;
+    void* data;
+} job_decl_t;
+
+/* Range body for jobs_parallel_for, covering indices begin..end-1 */
+typedef void (*job_range_fn_t)(void* user_data, i32 begin, i32 end);
+
+/* Completion counter
+ * Counts jobs started against it that have not finished. Zero-initialize
+ * it and leave the fields alone; it must outlive every job counted on it
+ * and every jobs_run_after that waits on it. */
+typedef struct job_counter {
+    i32 pending;
+    i32 lock;
+    struct job_batch* waiting;  /* Jobs held back until pending reaches zero */
+} job_counter_t;
+
+/* Job system initialization
+ * Starts worker_count workers (0 picks one per extra CPU core; negative runs
+ * every job inline on the thread that submits it). Each worker owns a
+ * work-stealing deque and takes work from the others when its own runs
+ * dry. engine_init calls this with engine_config_t.job_workers. */
+ENGINE_API engine_result_t jobs_init(i32 worker_count);
+ENGINE_API void jobs_shutdown(void);  /* Finishes queued jobs first */
+ENGINE_API i32 jobs_get_worker_count(void);  /* 0 when jobs run inline */
+
+/* Submit jobs; counter may be NULL. Safe from any thread, including jobs. */
+ENGINE_API void jobs_run(const job_decl_t* jobs, i32 count, job_counter_t* counter);
+
+/* Submit jobs that start once dependency reaches zero
+ * counter counts them from now, so waiting on it also waits for dependency. */
+ENGINE_API void jobs_run_after(job_counter_t* dependency, const job_decl_t* jobs, i32 count,
+                               job_counter_t* counter);
+
+/* Wait for counter to reach zero, running queued jobs meanwhile */
+ENGINE_API void jobs_wait(job_counter_t* counter);
+ENGINE_API bool jobs_is_done(const job_counter_t* counter);
+
+/* Run fn over 0..count-1 in chunks of grain indices (0 picks a size from
+ * the worker count) and wait for all of them */
+ENGINE_API void jobs_parallel_for(i32 count, i32 grain, job_range_fn_t fn, void* user_data);
+
+#endif /* ENGINE_JOBS_H */
@@ -124,6 +124,12 @@ typedef struct {
 /* Event callback */
 typedef void (*engine_event_callback_t)(const engine_event_t* event, void* user_data);
 
+/* Rectangle in window pixels */
+typedef struct {
+    i32 x, y;
+    i32 width, height;
+} platform_rect_t;
+
 /* Window creation parameters */
 typedef struct {
     const char* title;
@@ -228,10 +234,102 @@ ENGINE_API void platform_window_present_buffer(
     i32 height
 );
 
+/**
+ * Present only parts of a pixel buffer to the window
+ * Pixels outside the rects are left as they were on screen. With no rects
+ * nothing is copied, but the frame still ends (see platform_set_headless).
+ * @param window Window to present to
+ * @param pixels RGBA pixel buffer (pitch * height * 4 bytes)
+ * @param width Buffer width
+ * @param height Buffer height
+ * @param pitch Pixels from one buffer row to the next
+ * @param rects Areas of the buffer to present, NULL if rect_count is 0
+ * @param rect_count Number of rects
+ */
+ENGINE_API void platform_window_present_rects(
+    platform_window_t* window,
+    const u32* pixels,
+    i32 width,
+    i32 height,
+    i32 pitch,
+    const platform_rect_t* rects,
+    i32 rect_count
+);
+
+/**
+ * A page of the display the caller can draw into directly
+ */
+typedef struct {
+    u32* pixels;  /* BGRX, 32 bits per pixel */
+    i32 width;
+    i32 height;
+    i32 pitch;    /* Bytes from one row to the next */
+} platform_surface_t;
+
+/**
+ * Get the off-screen page for direct rendering
+ * Only available when the display is 32bpp BGRX and can flip between two
+ * pages; otherwise present a buffer instead.
+ * @param window Window to draw to
+ * @param out_surface Receives the page that the next flip shows
+ * @return true if out_surface was filled
+ */
+ENGINE_API bool platform_window_get_back_surface(platform_window_t* window, platform_surface_t* out_surface);
+
+/**
+ * Show the back page without copying; the old front page becomes the back
+ * @param window Window to flip
+ */
+ENGINE_API void platform_window_flip(platform_window_t* window);
+
+/* Headless backend settings */
+typedef struct {
+    const char* dump_pattern;  /* Path with one integer conversion for the frame number, e.g. "f%05d.qoi";
+                                * .qoi dumps QOI, else PPM. NULL for none; other patterns are rejected */
+    i32 dump_interval;         /* Dump every Nth frame, 0 or 1 for all */
+    const char* script_path;   /* Scripted input events, NULL for none */
+} platform_headless_config_t;
+
+/**
+ * Create later windows headless: they present into memory and read input
+ * from a script instead of /dev/fb0 and evdev. Each present or flip is one
+ * frame. ENGINE_PLATFORM=headless selects this at startup, configured by
+ * ENGINE_HEADLESS_DUMP, ENGINE_HEADLESS_DUMP_INTERVAL and ENGINE_HEADLESS_SCRIPT;
+ * building with HEADLESS=1 makes it the default.
+ *
+ * Script lines are "<frame> <event> [args]", delivered by the first poll
+ * after that many frames: key_press KEY, key_release KEY, key KEY (press and
+ * release), mouse_move X Y, mouse_press BUTTON, mouse_release BUTTON,
+ * wheel DELTA, or close. KEY is a letter, digit, name such as ESCAPE or
+ * LEFT, or a key code; BUTTON is left, right or middle. # starts a comment.
+ * @param config Dump and script settings, NULL for none
+ */
+ENGINE_API void platform_set_headless(const platform_headless_config_t* config);
+
+/**
+ * Check whether new windows are created headless
+ * @return true if headless
+ */
+ENGINE_API bool platform_is_headless(void);
+
+/**
+ * Get the number of frames a window has presented
+ * @param window Window to query
+ * @return Presents and flips so far
+ */
+ENGINE_API u32 platform_window_get_frame_count(const platform_window_t* window);
+
 /**
  * Sleep for specified milliseconds
  * @param milliseconds Time to sleep
  */
 ENGINE_API void platform_sleep(u32 milliseconds);
 
+/**
+ * Sleep until platform_get_time reaches a deadline
+ * May wake up to a scheduler tick late; returns at once if it has passed.
+ * @param time Deadline on the platform_get_time clock
+ */
+ENGINE_API void platform_sleep_until(f64 time);
+
 #endif /* ENGINE_PLATFORM_H */
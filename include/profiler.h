@@ -0,0 +1,55 @@
+#ifndef ENGINE_PROFILER_H
+#define ENGINE_PROFILER_H
+
+#include "types.h"
+#include "graphics.h"
+
+/* Timing zones
+ * ENGINE_PROFILE_BEGIN and ENGINE_PROFILE_END bracket a zone on the calling
+ * thread. Zones nest, and names must be string literals. Zones are only
+ * recorded in builds with ENGINE_ENABLE_PROFILING (make PROFILE=1); otherwise
+ * the macros compile to nothing. Call ENGINE_PROFILE_FRAME once per frame;
+ * every window present or flip does this already. */
+#ifdef ENGINE_ENABLE_PROFILING
+    #define ENGINE_PROFILE_BEGIN(name) profiler_begin(name)
+    #define ENGINE_PROFILE_END() profiler_end()
+    #define ENGINE_PROFILE_FRAME() profiler_frame()
+    #define ENGINE_PROFILE_THREAD(name) profiler_set_thread_name(name)
+#else
+    #define ENGINE_PROFILE_BEGIN(name) ((void)0)
+    #define ENGINE_PROFILE_END() ((void)0)
+    #define ENGINE_PROFILE_FRAME() ((void)0)
+    #define ENGINE_PROFILE_THREAD(name) ((void)0)
+#endif
+
+#define PROFILER_MAX_ZONES 64  /* Distinct zone names in the frame stats */
+
+/* Per-zone totals for the last frame */
+typedef struct {
+    const char* name;
+    f64 ms;       /* Time inside the zone, summed over calls and threads */
+    f64 avg_ms;   /* Smoothed over recent frames */
+    i32 calls;
+    i32 depth;    /* Shallowest nesting depth seen */
+} profiler_zone_stats_t;
+
+/* Recording; use the macros above instead so zones vanish from normal builds */
+ENGINE_API void profiler_begin(const char* name);
+ENGINE_API void profiler_end(void);
+ENGINE_API void profiler_set_thread_name(const char* name);  /* Shown in traces */
+
+/* Frame statistics
+ * profiler_frame closes the current frame and folds every zone that ended
+ * during it, on any thread, into the stats. */
+ENGINE_API void profiler_frame(void);
+ENGINE_API f64 profiler_get_frame_ms(void);
+ENGINE_API i32 profiler_get_zone_stats(const profiler_zone_stats_t** out_stats);
+
+/* Draw the last frame's zone table with its top-left corner at x, y */
+ENGINE_API void profiler_draw_overlay(graphics_context_t* ctx, i32 x, i32 y);
+
+/* Write the zones still held in the per-thread buffers as a Chrome
+ * trace-event JSON file (chrome://tracing, Perfetto) */
+ENGINE_API bool profiler_export_chrome_trace(const char* filename);
+
+#endif /* ENGINE_PROFILER_H */
@@ -0,0 +1,54 @@
+#ifndef ENGINE_SIMULATION_H
+#define ENGINE_SIMULATION_H
+
+#include "types.h"
+
+/* Forward declaration */
+typedef struct simulation simulation_t;
+
+/* Advance the simulation by one fixed step of dt seconds */
+typedef void (*simulation_tick_fn)(f64 dt, u64 tick, void* user_data);
+
+/* Write the state the renderer needs into a snapshot of snapshot_size bytes */
+typedef void (*simulation_snapshot_fn)(void* snapshot, void* user_data);
+
+/* Simulation configuration
+ * With threaded set, tick and snapshot run on a simulation thread of their
+ * own, so they must not touch state the render thread uses without locking
+ * it. Otherwise they run inside simulation_update on the calling thread. */
+typedef struct {
+    f64 tick_rate;                  /* Ticks per second, 0 picks 60 */
+    size_t snapshot_size;           /* Bytes per snapshot */
+    simulation_tick_fn tick;
+    simulation_snapshot_fn snapshot;
+    void* user_data;
+    bool threaded;
+} simulation_config_t;
+
+/* The two newest snapshots, for the renderer to blend
+ * Rendering runs one tick behind the simulation: alpha goes from 0 (show
+ * previous) when current is published to 1 (show current) one tick later. */
+typedef struct {
+    const void* previous;
+    const void* current;
+    f32 alpha;
+    u64 tick;                       /* Ticks completed when current was taken */
+} simulation_frame_t;
+
+/* Create a simulation; the snapshot for tick 0 is taken before this returns */
+ENGINE_API engine_result_t simulation_create(const simulation_config_t* config, simulation_t** out_sim);
+ENGINE_API void simulation_destroy(simulation_t* sim);  /* Stops and joins the thread */
+
+/* Run the ticks that are due; does nothing for a threaded simulation */
+ENGINE_API void simulation_update(simulation_t* sim);
+
+/* Pick up the newest snapshot and blend factor for now
+ * Call from one render thread only. The pointers stay valid until its next
+ * call. Until a second snapshot arrives, previous equals current. */
+ENGINE_API void simulation_acquire(simulation_t* sim, simulation_frame_t* out_frame);
+
+/* Queries */
+ENGINE_API u64 simulation_get_tick_count(const simulation_t* sim);
+ENGINE_API f64 simulation_get_tick_interval(const simulation_t* sim);  /* Seconds */
+
+#endif /* ENGINE_SIMULATION_H */
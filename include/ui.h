@@ -4,6 +4,7 @@
 #include "types.h"
 #include "graphics.h"
 #include "platform.h"
+#include "arena.h"
 
 /* Forward declarations */
 typedef struct ui_context ui_context_t;
@@ -61,6 +62,10 @@ ENGINE_API void ui_destroy_context(ui_context_t* ctx);
 ENGINE_API void ui_begin_frame(ui_context_t* ctx);
 ENGINE_API void ui_end_frame(ui_context_t* ctx);
 
+/* Scratch memory for text and other data passed to widgets, valid until
+ * the ui_begin_frame after next */
+ENGINE_API frame_arena_t* ui_get_frame_arena(ui_context_t* ctx);
+
 /* Input */
 ENGINE_API void ui_input_mouse_move(ui_context_t* ctx, i32 x, i32 y);
 ENGINE_API void ui_input_mouse_button(ui_context_t* ctx, bool down);
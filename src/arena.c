@@ -0,0 +1,192 @@
+#include "../include/arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+
+#define ARENA_DEFAULT_CAPACITY ((size_t)64 << 10)
+#define ARENA_ALIGNMENT 16
+
+/* A chunk of arena memory; data follows the header */
+typedef struct arena_block {
+    struct arena_block* next;
+    size_t size;
+    size_t used;
+} arena_block_t;
+
+#define ARENA_HEADER_SIZE ((sizeof(arena_block_t) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+/* One frame's worth of blocks; current is the last one in the chain */
+typedef struct {
+    arena_block_t* first;
+    arena_block_t* current;
+    size_t used;
+} arena_half_t;
+
+struct frame_arena {
+    arena_half_t halves[2];
+    i32 index;  /* Half taking this frame's allocations */
+    size_t capacity;
+};
+
+static inline u8* block_data(arena_block_t* block) {
+    return (u8*)block + ARENA_HEADER_SIZE;
+}
+
+static arena_block_t* block_create(size_t size) {
+    arena_block_t* block = (arena_block_t*)malloc(ARENA_HEADER_SIZE + size);
+    if (!block) return NULL;
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+static void half_free(arena_half_t* half) {
+    arena_block_t* block = half->first;
+    while (block) {
+        arena_block_t* next = block->next;
+        free(block);
+        block = next;
+    }
+    half->first = NULL;
+    half->current = NULL;
+    half->used = 0;
+}
+
+/* Helper: Empty a half, folding any overflow blocks into one */
+static void half_reset(arena_half_t* half) {
+    if (half->first && half->first->next) {
+        size_t total = 0;
+        for (arena_block_t* block = half->first; block; block = block->next) {
+            total += block->size;
+        }
+        half_free(half);
+        half->first = block_create(total);
+        half->current = half->first;
+    }
+    
+    if (half->first) half->first->used = 0;
+    half->current = half->first;
+    half->used = 0;
+}
+
+frame_arena_t* frame_arena_create(size_t capacity) {
+    frame_arena_t* arena = (frame_arena_t*)calloc(1, sizeof(frame_arena_t));
+    if (!arena) {
+        ENGINE_LOG_ERROR("Failed to allocate frame arena");
+        return NULL;
+    }
+    
+    arena->capacity = capacity > 0 ? capacity : ARENA_DEFAULT_CAPACITY;
+    for (i32 i = 0; i < 2; i++) {
+        arena->halves[i].first = block_create(arena->capacity);
+        arena->halves[i].current = arena->halves[i].first;
+        if (!arena->halves[i].first) {
+            ENGINE_LOG_ERROR("Failed to allocate frame arena memory");
+            frame_arena_destroy(arena);
+            return NULL;
+        }
+    }
+    return arena;
+}
+
+void frame_arena_destroy(frame_arena_t* arena) {
+    if (!arena) return;
+    half_free(&arena->halves[0]);
+    half_free(&arena->halves[1]);
+    free(arena);
+}
+
+void frame_arena_swap(frame_arena_t* arena) {
+    if (!arena) return;
+    arena->index ^= 1;
+    half_reset(&arena->halves[arena->index]);
+}
+
+void* frame_arena_alloc_aligned(frame_arena_t* arena, size_t size, size_t alignment) {
+    if (!arena) return NULL;
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        alignment = ARENA_ALIGNMENT;
+    }
+    
+    arena_half_t* half = &arena->halves[arena->index];
+    arena_block_t* block = half->current;
+    if (block) {
+        uintptr_t base = (uintptr_t)block_data(block);
+        size_t offset = ((base + block->used + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+        if (offset + size <= block->size) {
+            half->used += offset + size - block->used;
+            block->used = offset + size;
+            return block_data(block) + offset;
+        }
+    }
+    
+    /* Out of room: chain a block twice the size of the last one */
+    size_t grow = block ? block->size * 2 : arena->capacity;
+    if (grow < size + alignment) grow = size + alignment;
+    arena_block_t* next = block_create(grow);
+    if (!next) {
+        ENGINE_LOG_ERROR("Failed to grow frame arena by %zu bytes", grow);
+        return NULL;
+    }
+    if (block) {
+        block->next = next;
+    } else {
+        half->first = next;
+    }
+    half->current = next;
+    
+    uintptr_t base = (uintptr_t)block_data(next);
+    size_t offset = ((base + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+    next->used = offset + size;
+    half->used += offset + size;
+    return block_data(next) + offset;
+}
+
+void* frame_arena_alloc(frame_arena_t* arena, size_t size) {
+    return frame_arena_alloc_aligned(arena, size, ARENA_ALIGNMENT);
+}
+
+char* frame_arena_strdup(frame_arena_t* arena, const char* str) {
+    if (!str) return NULL;
+    size_t len = strlen(str);
+    char* copy = (char*)frame_arena_alloc_aligned(arena, len + 1, 1);
+    if (copy) memcpy(copy, str, len + 1);
+    return copy;
+}
+
+char* frame_arena_printf(frame_arena_t* arena, const char* format, ...) {
+    if (!format) return NULL;
+    
+    va_list args;
+    va_start(args, format);
+    i32 len = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (len < 0) return NULL;
+    
+    char* text = (char*)frame_arena_alloc_aligned(arena, (size_t)len + 1, 1);
+    if (!text) return NULL;
+    
+    va_start(args, format);
+    vsnprintf(text, (size_t)len + 1, format, args);
+    va_end(args);
+    return text;
+}
+
+size_t frame_arena_get_used(const frame_arena_t* arena) {
+    return arena ? arena->halves[arena->index].used : 0;
+}
+
+size_t frame_arena_get_capacity(const frame_arena_t* arena) {
+    if (!arena) return 0;
+    
+    size_t total = 0;
+    for (i32 i = 0; i < 2; i++) {
+        for (const arena_block_t* block = arena->halves[i].first; block; block = block->next) {
+            total += block->size;
+        }
+    }
+    return total;
+}
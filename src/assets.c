@@ -0,0 +1,572 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/assets.h"
+#include "../include/profiler.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#define ASSETS_DEFAULT_THREADS 2
+#define ASSETS_MAX_THREADS 8
+#define ASSETS_CACHE_BUCKETS 256                   /* Power of two */
+#define ASSETS_DEFAULT_CACHE_BUDGET ((size_t)64 << 20)
+
+/* One completion callback registered on a request */
+typedef struct asset_callback_entry {
+    asset_callback_t fn;
+    void* user_data;
+    struct asset_callback_entry* next;
+} asset_callback_entry_t;
+
+/* Asset request structure */
+struct asset_request {
+    asset_type_t type;
+    char* path;
+    asset_priority_t priority;
+    u64 sequence;                      /* Request order, breaks priority ties */
+    asset_state_t state;               /* Written under the lock, read atomically */
+    i32 refs;                          /* Caller handles plus queue ownership */
+    void* asset;                       /* graphics_image_t* or audio_sound_t* */
+    asset_callback_entry_t* callbacks; /* Not yet run, in registration order */
+    size_t size;                       /* Bytes counted against the cache budget */
+    u32 hash;
+    bool cached;                       /* Listed in the cache table */
+    bool queued;                       /* In the finished list, waiting for assets_update */
+    struct asset_request* bucket_next; /* Cache table chain */
+    struct asset_request* lru_prev;    /* Unreferenced entries, least recently used first */
+    struct asset_request* lru_next;
+};
+
+/* Global asset loader state */
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t work;      /* Pending requests or shutdown */
+    pthread_cond_t done;      /* A request finished */
+    pthread_t threads[ASSETS_MAX_THREADS];
+    i32 thread_count;
+    bool initialized;
+    bool shutdown;
+    
+    /* Requests not yet finished, each holding one reference. Short enough
+     * in practice that a linear scan beats keeping a heap in order. */
+    asset_request_t** active;
+    i32 active_count;
+    i32 active_capacity;
+    
+    /* Finished requests whose callbacks have not run, each holding one reference */
+    asset_request_t** finished;
+    i32 finished_count;
+    i32 finished_capacity;
+    
+    u64 next_sequence;
+    
+    /* Cache: every request in flight or loaded, by type and path. Entries
+     * nobody holds a handle to wait on the LRU list until the budget needs
+     * their memory. */
+    asset_request_t* buckets[ASSETS_CACHE_BUCKETS];
+    asset_request_t* lru_head;
+    asset_request_t* lru_tail;
+    size_t budget;
+    asset_cache_stats_t stats;
+} g_assets = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+    .budget = ASSETS_DEFAULT_CACHE_BUDGET,
+};
+
+/* Helper: Append to a request array, growing it as needed. Caller holds the lock. */
+static bool request_array_push(asset_request_t*** array, i32* count, i32* capacity, asset_request_t* request) {
+    if (*count == *capacity) {
+        i32 new_capacity = *capacity ? *capacity * 2 : 16;
+        asset_request_t** grown = (asset_request_t**)realloc(*array, (size_t)new_capacity * sizeof(asset_request_t*));
+        if (!grown) return false;
+        *array = grown;
+        *capacity = new_capacity;
+    }
+    (*array)[(*count)++] = request;
+    return true;
+}
+
+/* Helper: Remove a request from the active list. Caller holds the lock. */
+static void active_remove(asset_request_t* request) {
+    for (i32 i = 0; i < g_assets.active_count; i++) {
+        if (g_assets.active[i] == request) {
+            g_assets.active[i] = g_assets.active[--g_assets.active_count];
+            return;
+        }
+    }
+}
+
+static void request_destroy(asset_request_t* request) {
+    if (request->asset) {
+        if (request->type == ASSET_TYPE_IMAGE) {
+            graphics_destroy_image((graphics_image_t*)request->asset);
+        } else {
+            audio_destroy_sound((audio_sound_t*)request->asset);
+        }
+    }
+    
+    asset_callback_entry_t* entry = request->callbacks;
+    while (entry) {
+        asset_callback_entry_t* next = entry->next;
+        free(entry);
+        entry = next;
+    }
+    
+    free(request->path);
+    free(request);
+}
+
+/* Helper: FNV-1a over the path, seeded with the asset type */
+static u32 path_hash(asset_type_t type, const char* path) {
+    u32 hash = 2166136261u ^ (u32)type;
+    for (const u8* p = (const u8*)path; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
+}
+
+/* Cache table and LRU helpers. Caller holds the lock. */
+static asset_request_t* cache_find(asset_type_t type, const char* path, u32 hash) {
+    asset_request_t* r = g_assets.buckets[hash & (ASSETS_CACHE_BUCKETS - 1)];
+    for (; r; r = r->bucket_next) {
+        if (r->hash == hash && r->type == type && strcmp(r->path, path) == 0) return r;
+    }
+    return NULL;
+}
+
+static void cache_insert(asset_request_t* request) {
+    asset_request_t** bucket = &g_assets.buckets[request->hash & (ASSETS_CACHE_BUCKETS - 1)];
+    request->bucket_next = *bucket;
+    *bucket = request;
+    request->cached = true;
+    g_assets.stats.entries++;
+}
+
+static void cache_remove(asset_request_t* request) {
+    if (!request->cached) return;
+    
+    asset_request_t** link = &g_assets.buckets[request->hash & (ASSETS_CACHE_BUCKETS - 1)];
+    while (*link != request) link = &(*link)->bucket_next;
+    *link = request->bucket_next;
+    request->bucket_next = NULL;
+    request->cached = false;
+    g_assets.stats.entries--;
+    if (request->asset) g_assets.stats.bytes_resident -= request->size;
+}
+
+static void lru_push(asset_request_t* request) {
+    request->lru_prev = g_assets.lru_tail;
+    request->lru_next = NULL;
+    if (g_assets.lru_tail) {
+        g_assets.lru_tail->lru_next = request;
+    } else {
+        g_assets.lru_head = request;
+    }
+    g_assets.lru_tail = request;
+    g_assets.stats.unreferenced++;
+}
+
+static void lru_unlink(asset_request_t* request) {
+    if (request->lru_prev) {
+        request->lru_prev->lru_next = request->lru_next;
+    } else {
+        g_assets.lru_head = request->lru_next;
+    }
+    if (request->lru_next) {
+        request->lru_next->lru_prev = request->lru_prev;
+    } else {
+        g_assets.lru_tail = request->lru_prev;
+    }
+    request->lru_prev = request->lru_next = NULL;
+    g_assets.stats.unreferenced--;
+}
+
+/* Helper: Evict unreferenced entries, oldest first, until the cache fits its budget (or limit 0 empties it) */
+static void cache_trim_locked(size_t limit) {
+    while (g_assets.lru_head && g_assets.stats.bytes_resident > limit) {
+        asset_request_t* victim = g_assets.lru_head;
+        lru_unlink(victim);
+        cache_remove(victim);
+        request_destroy(victim);
+    }
+}
+
+/* Helper: Drop one reference. A loaded entry stays cached once unreferenced,
+ * for the caller's next cache_trim_locked to evict; otherwise the caller
+ * destroys the request after unlocking if this returns true. */
+static bool request_unref_locked(asset_request_t* request) {
+    if (--request->refs > 0) return false;
+    if (!request->cached) return true;
+    
+    lru_push(request);
+    return false;
+}
+
+static void set_state(asset_request_t* request, asset_state_t state) {
+    __atomic_store_n(&request->state, state, __ATOMIC_RELEASE);
+}
+
+/* Helper: Highest priority pending request, oldest first on ties. Caller holds the lock. */
+static asset_request_t* next_pending(void) {
+    asset_request_t* best = NULL;
+    for (i32 i = 0; i < g_assets.active_count; i++) {
+        asset_request_t* r = g_assets.active[i];
+        if (r->state != ASSET_STATE_PENDING) continue;
+        if (!best || r->priority > best->priority ||
+            (r->priority == best->priority && r->sequence < best->sequence)) {
+            best = r;
+        }
+    }
+    return best;
+}
+
+static void* loader_thread(void* arg) {
+    ENGINE_UNUSED(arg);
+    ENGINE_PROFILE_THREAD("asset loader");
+    
+    pthread_mutex_lock(&g_assets.lock);
+    while (!g_assets.shutdown) {
+        asset_request_t* request = next_pending();
+        if (!request) {
+            pthread_cond_wait(&g_assets.work, &g_assets.lock);
+            continue;
+        }
+        
+        set_state(request, ASSET_STATE_LOADING);
+        pthread_mutex_unlock(&g_assets.lock);
+        
+        void* asset;
+        ENGINE_PROFILE_BEGIN("load_asset");
+        if (request->type == ASSET_TYPE_IMAGE) {
+            asset = graphics_load_image(request->path);
+        } else {
+            asset = audio_load_sound(request->path);
+        }
+        ENGINE_PROFILE_END();
+        
+        /* Sounds keep their file data loaded, so the file size stands in for them */
+        size_t size = 0;
+        if (asset && request->type == ASSET_TYPE_IMAGE) {
+            graphics_image_t* image = (graphics_image_t*)asset;
+            size = (size_t)graphics_image_get_width(image) * graphics_image_get_height(image) * sizeof(u32);
+        } else if (asset) {
+            struct stat st;
+            if (stat(request->path, &st) == 0) size = (size_t)st.st_size;
+        }
+        
+        pthread_mutex_lock(&g_assets.lock);
+        request->asset = asset;
+        request->size = size;
+        active_remove(request);
+        if (asset) {
+            g_assets.stats.bytes_resident += size;
+        } else {
+            cache_remove(request);  /* Let a later request retry */
+        }
+        set_state(request, asset ? ASSET_STATE_READY : ASSET_STATE_FAILED);
+        
+        /* The queue's reference moves to the callback list, or is dropped */
+        bool destroy = false;
+        if (request->callbacks &&
+            request_array_push(&g_assets.finished, &g_assets.finished_count, &g_assets.finished_capacity, request)) {
+            request->queued = true;
+        } else {
+            destroy = request_unref_locked(request);
+        }
+        cache_trim_locked(g_assets.budget);
+        pthread_cond_broadcast(&g_assets.done);
+        
+        if (destroy) {
+            pthread_mutex_unlock(&g_assets.lock);
+            request_destroy(request);
+            pthread_mutex_lock(&g_assets.lock);
+        }
+    }
+    pthread_mutex_unlock(&g_assets.lock);
+    return NULL;
+}
+
+engine_result_t assets_init(i32 thread_count) {
+    if (g_assets.initialized) {
+        ENGINE_LOG_WARN("Assets already initialized");
+        return ENGINE_SUCCESS;
+    }
+    
+    if (thread_count <= 0) thread_count = ASSETS_DEFAULT_THREADS;
+    thread_count = ENGINE_MIN(thread_count, ASSETS_MAX_THREADS);
+    
+    g_assets.shutdown = false;
+    g_assets.thread_count = 0;
+    for (i32 i = 0; i < thread_count; i++) {
+        if (pthread_create(&g_assets.threads[i], NULL, loader_thread, NULL) != 0) {
+            ENGINE_LOG_WARN("Failed to start asset loader thread %d", i);
+            break;
+        }
+        g_assets.thread_count++;
+    }
+    
+    if (g_assets.thread_count == 0) {
+        ENGINE_LOG_ERROR("No asset loader threads could be started");
+        return ENGINE_ERROR;
+    }
+    
+    g_assets.initialized = true;
+    ENGINE_LOG_INFO("Asset system initialized: %d loader threads", g_assets.thread_count);
+    return ENGINE_SUCCESS;
+}
+
+void assets_shutdown(void) {
+    if (!g_assets.initialized) {
+        return;
+    }
+    
+    pthread_mutex_lock(&g_assets.lock);
+    g_assets.shutdown = true;
+    pthread_cond_broadcast(&g_assets.work);
+    pthread_mutex_unlock(&g_assets.lock);
+    
+    for (i32 i = 0; i < g_assets.thread_count; i++) {
+        pthread_join(g_assets.threads[i], NULL);
+    }
+    g_assets.thread_count = 0;
+    
+    /* Cancel what never started, drop callbacks that never ran and empty
+     * the cache. Handles callers still hold stay valid until released. */
+    pthread_mutex_lock(&g_assets.lock);
+    for (i32 i = 0; i < g_assets.active_count; i++) {
+        asset_request_t* request = g_assets.active[i];
+        cache_remove(request);
+        set_state(request, ASSET_STATE_FAILED);
+        if (request_unref_locked(request)) request_destroy(request);
+    }
+    for (i32 i = 0; i < g_assets.finished_count; i++) {
+        g_assets.finished[i]->queued = false;
+        if (request_unref_locked(g_assets.finished[i])) request_destroy(g_assets.finished[i]);
+    }
+    cache_trim_locked(0);
+    for (i32 i = 0; i < ASSETS_CACHE_BUCKETS; i++) {
+        while (g_assets.buckets[i]) cache_remove(g_assets.buckets[i]);
+    }
+    free(g_assets.active);
+    free(g_assets.finished);
+    g_assets.active = NULL;
+    g_assets.finished = NULL;
+    g_assets.active_count = g_assets.active_capacity = 0;
+    g_assets.finished_count = g_assets.finished_capacity = 0;
+    g_assets.initialized = false;
+    pthread_cond_broadcast(&g_assets.done);
+    pthread_mutex_unlock(&g_assets.lock);
+    
+    ENGINE_LOG_INFO("Asset system shut down");
+}
+
+void assets_update(void) {
+    if (!g_assets.initialized) return;
+    
+    /* Take the whole list so callbacks can queue new requests */
+    pthread_mutex_lock(&g_assets.lock);
+    asset_request_t** finished = g_assets.finished;
+    i32 count = g_assets.finished_count;
+    g_assets.finished = NULL;
+    g_assets.finished_count = 0;
+    g_assets.finished_capacity = 0;
+    pthread_mutex_unlock(&g_assets.lock);
+    
+    for (i32 i = 0; i < count; i++) {
+        asset_request_t* request = finished[i];
+        
+        pthread_mutex_lock(&g_assets.lock);
+        asset_callback_entry_t* entry = request->callbacks;
+        request->callbacks = NULL;
+        request->queued = false;
+        pthread_mutex_unlock(&g_assets.lock);
+        
+        while (entry) {
+            asset_callback_entry_t* next = entry->next;
+            entry->fn(request, entry->user_data);
+            free(entry);
+            entry = next;
+        }
+        asset_request_release(request);
+    }
+    free(finished);
+}
+
+i32 assets_get_pending_count(void) {
+    pthread_mutex_lock(&g_assets.lock);
+    i32 count = g_assets.active_count;
+    pthread_mutex_unlock(&g_assets.lock);
+    return count;
+}
+
+/* Helper: Find or queue a request and register one handle on it */
+static asset_request_t* assets_request(asset_type_t type, const char* path, asset_priority_t priority,
+                                       asset_callback_t callback, void* user_data) {
+    if (!g_assets.initialized) {
+        ENGINE_LOG_ERROR("Assets not initialized");
+        return NULL;
+    }
+    
+    if (!path) {
+        ENGINE_LOG_ERROR("Invalid asset path");
+        return NULL;
+    }
+    
+    asset_callback_entry_t* entry = NULL;
+    if (callback) {
+        entry = (asset_callback_entry_t*)malloc(sizeof(asset_callback_entry_t));
+        if (!entry) {
+            ENGINE_LOG_ERROR("Failed to allocate asset callback");
+            return NULL;
+        }
+        entry->fn = callback;
+        entry->user_data = user_data;
+        entry->next = NULL;
+    }
+    
+    pthread_mutex_lock(&g_assets.lock);
+    
+    /* Share a load that is in flight or already resident */
+    u32 hash = path_hash(type, path);
+    asset_request_t* request = cache_find(type, path, hash);
+    
+    if (request) {
+        g_assets.stats.hits++;
+        if (request->refs == 0) lru_unlink(request);
+        if (priority > request->priority) request->priority = priority;
+    } else {
+        size_t length = strlen(path);
+        request = (asset_request_t*)calloc(1, sizeof(asset_request_t));
+        char* copy = (char*)malloc(length + 1);
+        if (!request || !copy ||
+            !request_array_push(&g_assets.active, &g_assets.active_count, &g_assets.active_capacity, request)) {
+            pthread_mutex_unlock(&g_assets.lock);
+            ENGINE_LOG_ERROR("Failed to allocate asset request");
+            free(request);
+            free(copy);
+            free(entry);
+            return NULL;
+        }
+        
+        memcpy(copy, path, length + 1);
+        request->type = type;
+        request->path = copy;
+        request->hash = hash;
+        request->priority = priority;
+        request->sequence = g_assets.next_sequence++;
+        request->state = ASSET_STATE_PENDING;
+        request->refs = 1;  /* Queue ownership */
+        cache_insert(request);
+        g_assets.stats.misses++;
+        pthread_cond_signal(&g_assets.work);
+    }
+    request->refs++;
+    
+    if (entry) {
+        asset_callback_entry_t** tail = &request->callbacks;
+        while (*tail) tail = &(*tail)->next;
+        *tail = entry;
+        
+        /* A resident asset still reports through assets_update */
+        if (request->state == ASSET_STATE_READY && !request->queued &&
+            request_array_push(&g_assets.finished, &g_assets.finished_count, &g_assets.finished_capacity, request)) {
+            request->queued = true;
+            request->refs++;
+        }
+    }
+    
+    pthread_mutex_unlock(&g_assets.lock);
+    return request;
+}
+
+asset_request_t* assets_load_image(const char* path, asset_priority_t priority, asset_callback_t callback, void* user_data) {
+    return assets_request(ASSET_TYPE_IMAGE, path, priority, callback, user_data);
+}
+
+asset_request_t* assets_load_sound(const char* path, asset_priority_t priority, asset_callback_t callback, void* user_data) {
+    return assets_request(ASSET_TYPE_SOUND, path, priority, callback, user_data);
+}
+
+void asset_request_release(asset_request_t* request) {
+    if (!request) return;
+    
+    pthread_mutex_lock(&g_assets.lock);
+    
+    /* Only the queue would be left wanting a request that has not started: drop it */
+    if (request->refs == 2 && request->state == ASSET_STATE_PENDING && g_assets.initialized) {
+        active_remove(request);
+        cache_remove(request);
+        set_state(request, ASSET_STATE_FAILED);
+        request_unref_locked(request);
+    }
+    
+    /* The trim may evict the request itself, so it is not touched after */
+    bool destroy = request_unref_locked(request);
+    cache_trim_locked(g_assets.budget);
+    pthread_mutex_unlock(&g_assets.lock);
+    
+    if (destroy) {
+        request_destroy(request);
+    }
+}
+
+asset_state_t asset_request_get_state(const asset_request_t* request) {
+    if (!request) return ASSET_STATE_FAILED;
+    return __atomic_load_n(&request->state, __ATOMIC_ACQUIRE);
+}
+
+bool asset_request_is_done(const asset_request_t* request) {
+    asset_state_t state = asset_request_get_state(request);
+    return state == ASSET_STATE_READY || state == ASSET_STATE_FAILED;
+}
+
+void asset_request_wait(asset_request_t* request) {
+    if (!request) return;
+    
+    pthread_mutex_lock(&g_assets.lock);
+    while (!asset_request_is_done(request)) {
+        pthread_cond_wait(&g_assets.done, &g_assets.lock);
+    }
+    pthread_mutex_unlock(&g_assets.lock);
+}
+
+const char* asset_request_get_path(const asset_request_t* request) {
+    return request ? request->path : NULL;
+}
+
+graphics_image_t* asset_request_get_image(const asset_request_t* request) {
+    if (!request || request->type != ASSET_TYPE_IMAGE) return NULL;
+    if (asset_request_get_state(request) != ASSET_STATE_READY) return NULL;
+    return (graphics_image_t*)request->asset;
+}
+
+audio_sound_t* asset_request_get_sound(const asset_request_t* request) {
+    if (!request || request->type != ASSET_TYPE_SOUND) return NULL;
+    if (asset_request_get_state(request) != ASSET_STATE_READY) return NULL;
+    return (audio_sound_t*)request->asset;
+}
+
+void assets_set_cache_budget(size_t bytes) {
+    pthread_mutex_lock(&g_assets.lock);
+    g_assets.budget = bytes;
+    cache_trim_locked(bytes);
+    pthread_mutex_unlock(&g_assets.lock);
+}
+
+void assets_trim_cache(void) {
+    pthread_mutex_lock(&g_assets.lock);
+    cache_trim_locked(0);
+    pthread_mutex_unlock(&g_assets.lock);
+}
+
+void assets_get_cache_stats(asset_cache_stats_t* out_stats) {
+    if (!out_stats) return;
+    
+    pthread_mutex_lock(&g_assets.lock);
+    *out_stats = g_assets.stats;
+    out_stats->bytes_budget = g_assets.budget;
+    pthread_mutex_unlock(&g_assets.lock);
+}
@@ -9,13 +9,42 @@ typedef struct {
     bool logging_enabled;
     f64 start_time;
     char version_string[32];
+    frame_arena_t* frame_arena;  /* Swapped by engine_wait_frame */
 } engine_state_t;
 
 static engine_state_t g_engine_state = {0};
 
+/* Frame pacing */
+#define FRAME_BUCKET_MS 0.1
+#define FRAME_BUCKETS 1000      /* The last bucket takes every frame of 100 ms and up */
+#define FRAME_SPIN_MIN 0.0002   /* Seconds spun before a deadline, adapted to how late sleeps wake */
+#define FRAME_SPIN_MAX 0.004
+
+typedef struct {
+    f64 period;     /* Seconds, 0 when unpaced */
+    f64 deadline;   /* End of the current frame, 0 until scheduled */
+    f64 last_time;  /* When the previous frame ended, 0 before the first */
+    f64 spin;
+
+    /* Rolling window of frame times, with their histogram */
+    f32 times[ENGINE_FRAME_STATS_WINDOW];
+    bool late[ENGINE_FRAME_STATS_WINDOW];
+    i32 head;
+    i32 count;
+    i32 missed;
+    u32 histogram[FRAME_BUCKETS];
+    u64 total_frames;
+    u64 total_missed;
+} frame_pacer_t;
+
+static frame_pacer_t g_frame = { .period = 1.0 / 60.0 };
+
 /* Window wrapper structure */
 struct engine_window {
     platform_window_t* platform_window;
+    
+    /* Contexts over the two framebuffer pages, created on first use */
+    graphics_context_t* direct[2];
 };
 
 /* Helper function to get version string */
@@ -48,9 +77,26 @@ engine_result_t engine_init(const engine_config_t* config) {
         return result;
     }
 
+    /* Start the job system; without workers jobs still run, inline */
+    jobs_init(config ? config->job_workers : 0);
+
+    g_engine_state.frame_arena = frame_arena_create(0);
+    if (!g_engine_state.frame_arena) {
+        jobs_shutdown();
+        platform_shutdown();
+        return ENGINE_ERROR_OUT_OF_MEMORY;
+    }
+
     /* Record start time */
     g_engine_state.start_time = platform_get_time();
+    
+    /* A target set with engine_set_target_fps before init is kept */
+    f64 period = g_frame.period;
+    memset(&g_frame, 0, sizeof(g_frame));
+    g_frame.period = period;
+    g_frame.spin = 0.001;
     g_engine_state.initialized = true;
+    ENGINE_PROFILE_THREAD("main");
 
     /* Build version string */
     strncpy(g_engine_state.version_string, build_version_string(),
@@ -71,6 +117,9 @@ void engine_shutdown(void) {
 
     ENGINE_LOG_INFO("Shutting down engine");
 
+    jobs_shutdown();
+    frame_arena_destroy(g_engine_state.frame_arena);
+
     /* Shutdown platform layer */
     platform_shutdown();
 
@@ -137,6 +186,9 @@ void engine_window_destroy(engine_window_t* window) {
         return;
     }
 
+    graphics_destroy_context(window->direct[0]);
+    graphics_destroy_context(window->direct[1]);
+
     if (window->platform_window) {
         platform_window_destroy(window->platform_window);
     }
@@ -159,7 +211,9 @@ void engine_poll_events(void) {
         return;
     }
 
+    ENGINE_PROFILE_BEGIN("poll_events");
     platform_poll_events();
+    ENGINE_PROFILE_END();
 }
 
 i32 engine_window_get_width(const engine_window_t* window) {
@@ -196,6 +250,69 @@ void engine_window_set_visible(engine_window_t* window, bool visible) {
     platform_window_set_visible(window->platform_window, visible);
 }
 
+graphics_context_t* engine_window_get_direct_context(engine_window_t* window) {
+    if (!window || !window->platform_window) return NULL;
+
+    platform_surface_t surface;
+    if (!platform_window_get_back_surface(window->platform_window, &surface)) {
+        return NULL;
+    }
+
+    /* One context per page, matched by where its pixels start */
+    for (i32 i = 0; i < 2; i++) {
+        graphics_context_t* ctx = window->direct[i];
+        if (ctx && graphics_get_pixels(ctx) == surface.pixels) return ctx;
+    }
+
+    i32 slot = window->direct[0] ? 1 : 0;
+    graphics_context_t* ctx = graphics_create_context_from_pixels(surface.pixels, surface.width,
+                                                                  surface.height, surface.pitch);
+    if (!ctx) return NULL;
+    graphics_set_format(ctx, GRAPHICS_FORMAT_BGRA);
+    window->direct[slot] = ctx;
+    return ctx;
+}
+
+/* Helper: Show the frame held in gfx */
+static void present_frame(engine_window_t* window, graphics_context_t* gfx) {
+    /* A direct context already holds the frame: show its page */
+    if (gfx == window->direct[0] || gfx == window->direct[1]) {
+        graphics_flush(gfx);
+        platform_window_flip(window->platform_window);
+        graphics_reset_damage(gfx);
+        return;
+    }
+
+    /* Flush any deferred commands before reading the damage. Nothing drawn
+     * still ends the frame, which headless windows count and dump. */
+    const u32* pixels = graphics_get_pixels(gfx);
+    const graphics_rect_t* damage = NULL;
+    i32 count = graphics_get_damage(gfx, &damage);
+
+    platform_rect_t rects[GRAPHICS_MAX_DAMAGE_RECTS];
+    for (i32 i = 0; i < count; i++) {
+        rects[i].x = damage[i].x;
+        rects[i].y = damage[i].y;
+        rects[i].width = damage[i].width;
+        rects[i].height = damage[i].height;
+    }
+
+    platform_window_present_rects(window->platform_window, pixels,
+                                  graphics_get_width(gfx), graphics_get_height(gfx),
+                                  graphics_get_pitch(gfx) / (i32)sizeof(u32), rects, count);
+    graphics_reset_damage(gfx);
+}
+
+void engine_window_present(engine_window_t* window, graphics_context_t* gfx) {
+    if (!window || !window->platform_window || !gfx) {
+        ENGINE_LOG_WARN("Invalid parameters for present");
+        return;
+    }
+
+    /* The platform present times itself and ends the profiler frame */
+    present_frame(window, gfx);
+}
+
 const char* engine_get_version(void) {
     return g_engine_state.version_string;
 }
@@ -211,3 +328,140 @@ f64 engine_get_time(void) {
 
     return platform_get_time() - g_engine_state.start_time;
 }
+
+void engine_set_target_fps(f64 fps) {
+    g_frame.period = fps > 0.0 ? 1.0 / fps : 0.0;
+    g_frame.deadline = 0.0;
+}
+
+/* Helper: Histogram bucket for a frame time */
+static i32 frame_bucket(f64 ms) {
+    i32 bucket = (i32)(ms / FRAME_BUCKET_MS);
+    return ENGINE_CLAMP(bucket, 0, FRAME_BUCKETS - 1);
+}
+
+/* Helper: Add a frame to the window, dropping the oldest once it is full */
+static void record_frame(f64 ms, bool missed) {
+    i32 slot = g_frame.head;
+    if (g_frame.count == ENGINE_FRAME_STATS_WINDOW) {
+        g_frame.histogram[frame_bucket(g_frame.times[slot])]--;
+        if (g_frame.late[slot]) g_frame.missed--;
+    } else {
+        g_frame.count++;
+    }
+
+    g_frame.times[slot] = (f32)ms;
+    g_frame.late[slot] = missed;
+    g_frame.histogram[frame_bucket(ms)]++;
+    if (missed) {
+        g_frame.missed++;
+        g_frame.total_missed++;
+    }
+    g_frame.total_frames++;
+    g_frame.head = (slot + 1) % ENGINE_FRAME_STATS_WINDOW;
+}
+
+/* Helper: Sleep until shortly before deadline, then spin up to it */
+static void wait_until(f64 deadline) {
+    f64 wake = deadline - g_frame.spin;
+    if (wake > platform_get_time()) {
+        platform_sleep_until(wake);
+
+        /* Keep the spin a little longer than sleeps overshoot: grow it
+         * quickly after a late wake, shrink it slowly otherwise */
+        f64 overshoot = platform_get_time() - wake;
+        f64 want = overshoot * 1.5 + FRAME_SPIN_MIN;
+        g_frame.spin += (want - g_frame.spin) * (want > g_frame.spin ? 0.5 : 0.02);
+        g_frame.spin = ENGINE_CLAMP(g_frame.spin, FRAME_SPIN_MIN, FRAME_SPIN_MAX);
+    }
+
+    while (platform_get_time() < deadline) {
+    }
+}
+
+f64 engine_wait_frame(void) {
+    if (!g_engine_state.initialized) {
+        return 0.0;
+    }
+
+    f64 now = platform_get_time();
+    bool missed = false;
+    if (g_frame.period > 0.0) {
+        if (g_frame.deadline == 0.0) {
+            g_frame.deadline = (g_frame.last_time > 0.0 ? g_frame.last_time : now) + g_frame.period;
+        }
+
+        if (now > g_frame.deadline) {
+            missed = true;
+        } else {
+            ENGINE_PROFILE_BEGIN("wait_frame");
+            wait_until(g_frame.deadline);
+            ENGINE_PROFILE_END();
+            now = platform_get_time();
+        }
+
+        /* Stay on the schedule after a small overrun; after a whole lost
+         * period start over from now */
+        g_frame.deadline += g_frame.period;
+        if (g_frame.deadline <= now) {
+            g_frame.deadline = now + g_frame.period;
+        }
+    }
+
+    f64 delta = 0.0;
+    if (g_frame.last_time > 0.0) {
+        delta = now - g_frame.last_time;
+        record_frame(delta * 1000.0, missed);
+    }
+    g_frame.last_time = now;
+    frame_arena_swap(g_engine_state.frame_arena);
+    return delta;
+}
+
+frame_arena_t* engine_get_frame_arena(void) {
+    return g_engine_state.frame_arena;
+}
+
+/* Helper: Smallest frame time with at least fraction of the window at or below it */
+static f64 frame_percentile(f64 fraction) {
+    u32 rank = (u32)(fraction * g_frame.count + 0.999999);
+    if (rank == 0) rank = 1;
+
+    u32 seen = 0;
+    for (i32 i = 0; i < FRAME_BUCKETS; i++) {
+        seen += g_frame.histogram[i];
+        if (seen >= rank) return (i + 1) * FRAME_BUCKET_MS;
+    }
+    return FRAME_BUCKETS * FRAME_BUCKET_MS;
+}
+
+void engine_get_frame_stats(engine_frame_stats_t* out_stats) {
+    if (!out_stats) return;
+
+    memset(out_stats, 0, sizeof(*out_stats));
+    out_stats->target_ms = g_frame.period * 1000.0;
+    out_stats->frames = g_frame.count;
+    out_stats->missed = g_frame.missed;
+    out_stats->total_frames = g_frame.total_frames;
+    out_stats->total_missed = g_frame.total_missed;
+    if (g_frame.count == 0) return;
+
+    f64 sum = 0.0;
+    for (i32 i = 0; i < g_frame.count; i++) {
+        sum += g_frame.times[i];
+        if (g_frame.times[i] > out_stats->max_ms) out_stats->max_ms = g_frame.times[i];
+    }
+    out_stats->avg_ms = sum / g_frame.count;
+    out_stats->p50_ms = frame_percentile(0.50);
+    out_stats->p95_ms = frame_percentile(0.95);
+    out_stats->p99_ms = frame_percentile(0.99);
+}
+
+void engine_reset_frame_stats(void) {
+    g_frame.head = 0;
+    g_frame.count = 0;
+    g_frame.missed = 0;
+    g_frame.total_frames = 0;
+    g_frame.total_missed = 0;
+    memset(g_frame.histogram, 0, sizeof(g_frame.histogram));
+}
@@ -1,16 +1,38 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "../include/graphics.h"
+#include "../include/profiler.h"
+#include "../include/jobs.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 /* Graphics context structure */
 struct graphics_context {
     u32* pixels;         /* RGBA pixel buffer */
     i32 width;
     i32 height;
+    i32 pitch;           /* Pixels from one row to the next, at least width */
+    bool owns_pixels;    /* False for views and wrapped buffers */
+    struct graphics_context* parent;  /* Context a view aliases, gets its damage */
+    struct graphics_image* image;     /* Image an image view aliases, NULL otherwise */
+    i32 parent_x, parent_y;           /* View origin in the parent */
     graphics_rect_t clip_rect;
     bool clipping_enabled;
+    const struct graphics_span_ops* spans;  /* Span kernels picked at creation */
+    struct graphics_deferred* deferred;     /* Tile renderer state, NULL in immediate mode */
+    struct graphics_cmd_list* record;       /* Where draw calls are recorded, NULL to draw now */
+    struct graphics_cmd_list* record_saved; /* Target to restore when display list recording ends */
+    graphics_rect_t damage[GRAPHICS_MAX_DAMAGE_RECTS];  /* Area changed since the last reset */
+    i32 damage_count;
+    bool damage_tracking;  /* Off for the temporary copies used to execute commands */
+    graphics_format_t format;  /* How pixels store alpha */
 };
 
 /* Image structure */
@@ -18,6 +40,10 @@ struct graphics_image {
     u32* pixels;
     i32 width;
     i32 height;
+    graphics_opacity_t opacity;  /* Picks the blit path */
+    graphics_format_t format;
+    struct graphics_image* mip;  /* Next mip level, built on first large downscale */
+    i32 pitch;  /* Pixels from one row to the next; only layer views differ from width */
 };
 
 /* Built-in 12x16 font */
@@ -307,317 +333,1917 @@ static inline u32 blend_colors(u32 src, u32 dst) {
     return pack_color(result);
 }
 
-/* Color creation */
-graphics_color_t graphics_rgb(u8 r, u8 g, u8 b) {
-    graphics_color_t c = {r, g, b, 255};
-    return c;
+/* Helper: x * a / 255, rounded */
+static inline u32 mul_div_255(u32 x, u32 a) {
+    u32 t = x * a + 128;
+    return (t + (t >> 8)) >> 8;
 }
 
-graphics_color_t graphics_rgba(u8 r, u8 g, u8 b, u8 a) {
-    graphics_color_t c = {r, g, b, a};
-    return c;
+/* Helper: Straight to premultiplied alpha */
+static inline u32 premultiply(u32 c) {
+    u32 a = c >> 24;
+    if (a == 255) return c;
+    if (a == 0) return 0;
+    return (a << 24) | (mul_div_255((c >> 16) & 0xFF, a) << 16) |
+           (mul_div_255((c >> 8) & 0xFF, a) << 8) | mul_div_255(c & 0xFF, a);
 }
 
-graphics_color_t graphics_hex(u32 hex) {
-    graphics_color_t c;
-    c.r = (hex >> 16) & 0xFF;
-    c.g = (hex >> 8) & 0xFF;
-    c.b = hex & 0xFF;
-    c.a = 255;
+/* Helper: Premultiplied to straight alpha */
+static inline u32 unpremultiply(u32 c) {
+    u32 a = c >> 24;
+    if (a == 255 || a == 0) return c;
+    u32 r = ENGINE_MIN(((c & 0xFF) * 255 + a / 2) / a, 255);
+    u32 g = ENGINE_MIN((((c >> 8) & 0xFF) * 255 + a / 2) / a, 255);
+    u32 b = ENGINE_MIN((((c >> 16) & 0xFF) * 255 + a / 2) / a, 255);
+    return (a << 24) | (b << 16) | (g << 8) | r;
+}
+
+/* Helper: Swap the red and blue bytes */
+static inline u32 swap_red_blue(u32 c) {
+    return (c & 0xFF00FF00u) | ((c >> 16) & 0xFF) | ((c & 0xFF) << 16);
+}
+
+/* Helper: Convert one pixel between formats, by way of straight RGBA */
+static inline u32 convert_pixel(u32 c, graphics_format_t from, graphics_format_t to) {
+    if (from == to) return c;
+    if (from == GRAPHICS_FORMAT_PREMULTIPLIED) c = unpremultiply(c);
+    else if (from == GRAPHICS_FORMAT_BGRA) c = swap_red_blue(c);
+    if (to == GRAPHICS_FORMAT_PREMULTIPLIED) c = premultiply(c);
+    else if (to == GRAPHICS_FORMAT_BGRA) c = swap_red_blue(c);
     return c;
 }
 
-/* Context management */
-graphics_context_t* graphics_create_context(i32 width, i32 height) {
-    if (width <= 0 || height <= 0) {
-        ENGINE_LOG_ERROR("Invalid context dimensions");
-        return NULL;
+/* Helper: Convert a pixel buffer between formats in place */
+static void convert_pixels(u32* pixels, size_t count, graphics_format_t from, graphics_format_t to) {
+    if (from == to) return;
+    for (size_t i = 0; i < count; i++) {
+        pixels[i] = convert_pixel(pixels[i], from, to);
     }
+}
+
+/* Helper: Premultiplied "over". Every channel, alpha included, is s + d * (256 - a) / 256,
+ * one multiply per channel; (d * (256 - a)) >> 8 never exceeds 255 - a, so nothing carries. */
+static inline u32 blend_premultiplied(u32 src, u32 dst) {
+    u32 inv_alpha = 256 - (src >> 24);
+    u32 rb = (((dst & 0x00FF00FF) * inv_alpha) >> 8) & 0x00FF00FF;
+    u32 ag = (((dst >> 8) & 0x00FF00FF) * inv_alpha) & 0xFF00FF00;
+    return src + (rb | ag);
+}
+
+/* Span kernels
+ * All horizontal runs of pixels go through one of these. The scalar versions
+ * are always available; SSE2/AVX2 versions are compiled with per-function
+ * target attributes and picked once via cpuid in graphics_create_context.
+ * Every kernel produces exactly the same result as blend_colors(), or as
+ * blend_premultiplied() for the _premul kernels.
+ */
+typedef struct graphics_span_ops {
+    const char* name;
+    void (*fill)(u32* dst, i32 count, u32 color);   /* Opaque fill */
+    void (*blend)(u32* dst, i32 count, u32 color);  /* Constant-color blend, 0 < alpha < 255 */
+    void (*blit_masked)(u32* dst, const u32* src, i32 count);  /* Copy pixels whose alpha is not 0 */
+    void (*blit_blend)(u32* dst, const u32* src, i32 count);   /* Per-pixel alpha blend */
+    void (*blend_premul)(u32* dst, i32 count, u32 color);      /* Premultiplied constant-color blend */
+    void (*blit_blend_premul)(u32* dst, const u32* src, i32 count);  /* Premultiplied per-pixel blend */
     
-    graphics_context_t* ctx = (graphics_context_t*)malloc(sizeof(graphics_context_t));
-    if (!ctx) {
-        ENGINE_LOG_ERROR("Failed to allocate graphics context");
-        return NULL;
-    }
+    /* Bilinear row: dst[i] samples rows row0/row1 at 16.16 x = u + i * du, blended by fy/256 */
+    void (*scale_bilinear)(u32* dst, const u32* row0, const u32* row1, i32 count, i32 u, i32 du, u32 fy, i32 max_x);
     
-    ctx->pixels = (u32*)calloc(width * height, sizeof(u32));
-    if (!ctx->pixels) {
-        ENGINE_LOG_ERROR("Failed to allocate pixel buffer");
-        free(ctx);
-        return NULL;
+    /* File rows to RGBA: 32-bit BGRA keeps its alpha, 24-bit BGR gets alpha 255 */
+    void (*swizzle_bgra)(u32* dst, const u8* src, i32 count);
+    void (*swizzle_bgr)(u32* dst, const u8* src, i32 count);
+} graphics_span_ops_t;
+
+/* Spans at least this long (in pixels) bypass the cache with streaming stores */
+#define GRAPHICS_STREAM_THRESHOLD (1 << 20)
+
+static void span_fill_scalar(u32* dst, i32 count, u32 color) {
+    for (i32 i = 0; i < count; i++) {
+        dst[i] = color;
     }
+}
+
+static void span_blend_scalar(u32* dst, i32 count, u32 color) {
+    u32 a = color >> 24;
+    u32 alpha = a + 1;
+    u32 inv_alpha = 256 - a;
     
-    ctx->width = width;
-    ctx->height = height;
-    ctx->clipping_enabled = false;
-    ctx->clip_rect = graphics_rect(0, 0, width, height);
+    /* Red and blue are blended together in one 32-bit multiply */
+    u32 src_rb = (color & 0x00FF00FF) * alpha;
+    u32 src_g = ((color >> 8) & 0xFF) * alpha;
     
-    ENGINE_LOG_INFO("Graphics context created: %dx%d", width, height);
-    return ctx;
+    for (i32 i = 0; i < count; i++) {
+        u32 d = dst[i];
+        u32 rb = (((d & 0x00FF00FF) * inv_alpha + src_rb) >> 8) & 0x00FF00FF;
+        u32 g = (((d >> 8) & 0xFF) * inv_alpha + src_g) & 0xFF00;
+        dst[i] = 0xFF000000 | rb | g;
+    }
 }
 
-void graphics_destroy_context(graphics_context_t* ctx) {
-    if (!ctx) return;
-    
-    if (ctx->pixels) {
-        free(ctx->pixels);
+static void blit_masked_scalar(u32* dst, const u32* src, i32 count) {
+    for (i32 i = 0; i < count; i++) {
+        if (src[i] >> 24) dst[i] = src[i];
     }
-    free(ctx);
-    ENGINE_LOG_INFO("Graphics context destroyed");
 }
 
-i32 graphics_get_width(const graphics_context_t* ctx) {
-    return ctx ? ctx->width : 0;
+static void blit_blend_scalar(u32* dst, const u32* src, i32 count) {
+    for (i32 i = 0; i < count; i++) {
+        u32 s = src[i];
+        u32 a = s >> 24;
+        if (a == 255) {
+            dst[i] = s;
+        } else if (a != 0) {
+            dst[i] = blend_colors(s, dst[i]);
+        }
+    }
 }
 
-i32 graphics_get_height(const graphics_context_t* ctx) {
-    return ctx ? ctx->height : 0;
+static void span_blend_premul_scalar(u32* dst, i32 count, u32 color) {
+    for (i32 i = 0; i < count; i++) {
+        dst[i] = blend_premultiplied(color, dst[i]);
+    }
 }
 
-void graphics_resize(graphics_context_t* ctx, i32 width, i32 height) {
-    if (!ctx || width <= 0 || height <= 0) return;
-    
-    u32* new_pixels = (u32*)calloc(width * height, sizeof(u32));
-    if (!new_pixels) {
-        ENGINE_LOG_ERROR("Failed to resize graphics context");
-        return;
+static void blit_blend_premul_scalar(u32* dst, const u32* src, i32 count) {
+    for (i32 i = 0; i < count; i++) {
+        dst[i] = blend_premultiplied(src[i], dst[i]);
     }
-    
-    free(ctx->pixels);
-    ctx->pixels = new_pixels;
-    ctx->width = width;
-    ctx->height = height;
-    ctx->clip_rect = graphics_rect(0, 0, width, height);
 }
 
-/* Rendering control */
-void graphics_clear(graphics_context_t* ctx, graphics_color_t color) {
-    if (!ctx) return;
-    
-    u32 packed = pack_color(color);
-    for (i32 i = 0; i < ctx->width * ctx->height; i++) {
-        ctx->pixels[i] = packed;
+/* Helper: Texel pair and horizontal weight for 16.16 coordinate u, clamped to [0, max_x] */
+static inline i32 bilinear_texel(i32 u, i32 max_x, u32* fx) {
+    i32 x = u >> 16;
+    if (u < 0) {
+        *fx = 0;
+        return 0;
+    }
+    if (x >= max_x) {
+        *fx = 0;
+        return max_x;
     }
+    *fx = ((u32)u >> 8) & 0xFF;
+    return x;
 }
 
-void graphics_set_clip_rect(graphics_context_t* ctx, const graphics_rect_t* rect) {
-    if (!ctx || !rect) return;
-    
-    ctx->clip_rect = *rect;
-    ctx->clipping_enabled = true;
+static void scale_bilinear_scalar(u32* dst, const u32* row0, const u32* row1, i32 count, i32 u, i32 du, u32 fy, i32 max_x) {
+    for (i32 i = 0; i < count; i++, u += du) {
+        u32 fx;
+        i32 x0 = bilinear_texel(u, max_x, &fx);
+        i32 x1 = ENGINE_MIN(x0 + 1, max_x);
+        u32 t0 = row0[x0], t1 = row0[x1], b0 = row1[x0], b1 = row1[x1];
+        u32 out = 0;
+        
+        /* Vertical then horizontal, 8-bit weights, same rounding as the SIMD path */
+        for (u32 shift = 0; shift < 32; shift += 8) {
+            u32 v0 = (((t0 >> shift) & 0xFF) * (256 - fy) + ((b0 >> shift) & 0xFF) * fy) >> 8;
+            u32 v1 = (((t1 >> shift) & 0xFF) * (256 - fy) + ((b1 >> shift) & 0xFF) * fy) >> 8;
+            out |= ((v0 * (256 - fx) + v1 * fx) >> 8) << shift;
+        }
+        dst[i] = out;
+    }
 }
 
-void graphics_clear_clip_rect(graphics_context_t* ctx) {
-    if (!ctx) return;
-    
-    ctx->clip_rect = graphics_rect(0, 0, ctx->width, ctx->height);
-    ctx->clipping_enabled = false;
+static void swizzle_bgra_scalar(u32* dst, const u8* src, i32 count) {
+    for (i32 i = 0; i < count; i++, src += 4) {
+        dst[i] = ((u32)src[3] << 24) | ((u32)src[0] << 16) | ((u32)src[1] << 8) | src[2];
+    }
 }
 
-/* Drawing primitives */
-void graphics_draw_pixel(graphics_context_t* ctx, i32 x, i32 y, graphics_color_t color) {
-    if (!ctx) return;
+static void swizzle_bgr_scalar(u32* dst, const u8* src, i32 count) {
+    for (i32 i = 0; i < count; i++, src += 3) {
+        dst[i] = 0xFF000000u | ((u32)src[0] << 16) | ((u32)src[1] << 8) | src[2];
+    }
+}
+
+static const graphics_span_ops_t g_span_ops_scalar = {
+    "scalar", span_fill_scalar, span_blend_scalar, blit_masked_scalar, blit_blend_scalar,
+    span_blend_premul_scalar, blit_blend_premul_scalar, scale_bilinear_scalar,
+    swizzle_bgra_scalar, swizzle_bgr_scalar
+};
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GRAPHICS_HAVE_X86_SIMD 1
+#include <cpuid.h>
+#include <immintrin.h>
+
+__attribute__((target("sse2")))
+static void span_fill_sse2(u32* dst, i32 count, u32 color) {
+    /* Align destination to 16 bytes */
+    while (count > 0 && ((uintptr_t)dst & 15)) {
+        *dst++ = color;
+        count--;
+    }
     
-    /* Clipping */
-    if (ctx->clipping_enabled) {
-        if (x < ctx->clip_rect.x || x >= ctx->clip_rect.x + ctx->clip_rect.width ||
-            y < ctx->clip_rect.y || y >= ctx->clip_rect.y + ctx->clip_rect.height) {
-            return;
-        }
-    } else {
-        if (x < 0 || x >= ctx->width || y < 0 || y >= ctx->height) {
-            return;
+    __m128i c = _mm_set1_epi32((int)color);
+    if (count >= GRAPHICS_STREAM_THRESHOLD) {
+        for (; count >= 16; count -= 16, dst += 16) {
+            _mm_stream_si128((__m128i*)(dst + 0), c);
+            _mm_stream_si128((__m128i*)(dst + 4), c);
+            _mm_stream_si128((__m128i*)(dst + 8), c);
+            _mm_stream_si128((__m128i*)(dst + 12), c);
         }
+        _mm_sfence();
     }
-    
-    u32 packed = pack_color(color);
-    if (color.a == 255) {
-        ctx->pixels[y * ctx->width + x] = packed;
-    } else {
-        ctx->pixels[y * ctx->width + x] = blend_colors(packed, ctx->pixels[y * ctx->width + x]);
+    for (; count >= 16; count -= 16, dst += 16) {
+        _mm_store_si128((__m128i*)(dst + 0), c);
+        _mm_store_si128((__m128i*)(dst + 4), c);
+        _mm_store_si128((__m128i*)(dst + 8), c);
+        _mm_store_si128((__m128i*)(dst + 12), c);
+    }
+    for (; count >= 4; count -= 4, dst += 4) {
+        _mm_store_si128((__m128i*)dst, c);
+    }
+    while (count-- > 0) {
+        *dst++ = color;
     }
 }
 
-void graphics_draw_line(graphics_context_t* ctx, i32 x1, i32 y1, i32 x2, i32 y2, graphics_color_t color) {
-    if (!ctx) return;
+__attribute__((target("sse2")))
+static void span_blend_sse2(u32* dst, i32 count, u32 color) {
+    u32 a = color >> 24;
+    u32 alpha = a + 1;
+    u32 inv_alpha = 256 - a;
     
-    /* Bresenham's line algorithm */
-    i32 dx = abs(x2 - x1);
-    i32 dy = abs(y2 - y1);
-    i32 sx = x1 < x2 ? 1 : -1;
-    i32 sy = y1 < y2 ? 1 : -1;
-    i32 err = dx - dy;
+    /* 16-bit lanes per pixel are r, g, b, a; the alpha lane is forced to 255 */
+    short sr = (short)((color & 0xFF) * alpha);
+    short sg = (short)(((color >> 8) & 0xFF) * alpha);
+    short sb = (short)(((color >> 16) & 0xFF) * alpha);
+    __m128i src = _mm_set_epi16(0, sb, sg, sr, 0, sb, sg, sr);
+    __m128i inv = _mm_set1_epi16((short)inv_alpha);
+    __m128i zero = _mm_setzero_si128();
+    __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
     
-    while (1) {
-        graphics_draw_pixel(ctx, x1, y1, color);
-        
-        if (x1 == x2 && y1 == y2) break;
-        
-        i32 e2 = 2 * err;
-        if (e2 > -dy) {
-            err -= dy;
-            x1 += sx;
-        }
-        if (e2 < dx) {
-            err += dx;
-            y1 += sy;
-        }
+    for (; count >= 4; count -= 4, dst += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i*)dst);
+        __m128i lo = _mm_unpacklo_epi8(d, zero);
+        __m128i hi = _mm_unpackhi_epi8(d, zero);
+        lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(lo, inv), src), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(hi, inv), src), 8);
+        _mm_storeu_si128((__m128i*)dst, _mm_or_si128(_mm_packus_epi16(lo, hi), alpha_mask));
+    }
+    if (count > 0) {
+        span_blend_scalar(dst, count, color);
     }
 }
 
-void graphics_draw_rect(graphics_context_t* ctx, const graphics_rect_t* rect, graphics_color_t color) {
-    if (!ctx || !rect) return;
+__attribute__((target("avx2")))
+static void span_fill_avx2(u32* dst, i32 count, u32 color) {
+    /* Align destination to 32 bytes */
+    while (count > 0 && ((uintptr_t)dst & 31)) {
+        *dst++ = color;
+        count--;
+    }
     
-    /* Draw four lines */
-    graphics_draw_line(ctx, rect->x, rect->y, rect->x + rect->width - 1, rect->y, color);
-    graphics_draw_line(ctx, rect->x + rect->width - 1, rect->y, rect->x + rect->width - 1, rect->y + rect->height - 1, color);
-    graphics_draw_line(ctx, rect->x + rect->width - 1, rect->y + rect->height - 1, rect->x, rect->y + rect->height - 1, color);
-    graphics_draw_line(ctx, rect->x, rect->y + rect->height - 1, rect->x, rect->y, color);
+    __m256i c = _mm256_set1_epi32((int)color);
+    if (count >= GRAPHICS_STREAM_THRESHOLD) {
+        for (; count >= 32; count -= 32, dst += 32) {
+            _mm256_stream_si256((__m256i*)(dst + 0), c);
+            _mm256_stream_si256((__m256i*)(dst + 8), c);
+            _mm256_stream_si256((__m256i*)(dst + 16), c);
+            _mm256_stream_si256((__m256i*)(dst + 24), c);
+        }
+        _mm_sfence();
+    }
+    for (; count >= 32; count -= 32, dst += 32) {
+        _mm256_store_si256((__m256i*)(dst + 0), c);
+        _mm256_store_si256((__m256i*)(dst + 8), c);
+        _mm256_store_si256((__m256i*)(dst + 16), c);
+        _mm256_store_si256((__m256i*)(dst + 24), c);
+    }
+    for (; count >= 8; count -= 8, dst += 8) {
+        _mm256_store_si256((__m256i*)dst, c);
+    }
+    while (count-- > 0) {
+        *dst++ = color;
+    }
 }
 
-void graphics_fill_rect(graphics_context_t* ctx, const graphics_rect_t* rect, graphics_color_t color) {
-    if (!ctx || !rect) return;
+__attribute__((target("avx2")))
+static void span_blend_avx2(u32* dst, i32 count, u32 color) {
+    u32 a = color >> 24;
+    u32 alpha = a + 1;
+    u32 inv_alpha = 256 - a;
     
-    i32 x1 = rect->x;
-    i32 y1 = rect->y;
-    i32 x2 = rect->x + rect->width;
-    i32 y2 = rect->y + rect->height;
+    short sr = (short)((color & 0xFF) * alpha);
+    short sg = (short)(((color >> 8) & 0xFF) * alpha);
+    short sb = (short)(((color >> 16) & 0xFF) * alpha);
+    __m256i src = _mm256_set_epi16(0, sb, sg, sr, 0, sb, sg, sr,
+                                   0, sb, sg, sr, 0, sb, sg, sr);
+    __m256i inv = _mm256_set1_epi16((short)inv_alpha);
+    __m256i zero = _mm256_setzero_si256();
+    __m256i alpha_mask = _mm256_set1_epi32((int)0xFF000000);
     
-    /* Clip to clipping rect if enabled, otherwise to context bounds */
-    if (ctx->clipping_enabled) {
-        if (x1 < ctx->clip_rect.x) x1 = ctx->clip_rect.x;
-        if (y1 < ctx->clip_rect.y) y1 = ctx->clip_rect.y;
-        if (x2 > ctx->clip_rect.x + ctx->clip_rect.width) x2 = ctx->clip_rect.x + ctx->clip_rect.width;
-        if (y2 > ctx->clip_rect.y + ctx->clip_rect.height) y2 = ctx->clip_rect.y + ctx->clip_rect.height;
-    } else {
-        if (x1 < 0) x1 = 0;
-        if (y1 < 0) y1 = 0;
-        if (x2 > ctx->width) x2 = ctx->width;
-        if (y2 > ctx->height) y2 = ctx->height;
+    /* unpack/pack work within 128-bit lanes, so pixel order is preserved */
+    for (; count >= 8; count -= 8, dst += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i*)dst);
+        __m256i lo = _mm256_unpacklo_epi8(d, zero);
+        __m256i hi = _mm256_unpackhi_epi8(d, zero);
+        lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(lo, inv), src), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(hi, inv), src), 8);
+        _mm256_storeu_si256((__m256i*)dst, _mm256_or_si256(_mm256_packus_epi16(lo, hi), alpha_mask));
     }
+    if (count > 0) {
+        span_blend_sse2(dst, count, color);
+    }
+}
+
+__attribute__((target("sse2")))
+static void blit_masked_sse2(u32* dst, const u32* src, i32 count) {
+    __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
+    __m128i zero = _mm_setzero_si128();
     
-    /* Early exit if clipped out entirely */
-    if (x1 >= x2 || y1 >= y2) return;
-    
-    u32 packed = pack_color(color);
+    for (; count >= 4; count -= 4, dst += 4, src += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)src);
+        __m128i d = _mm_loadu_si128((const __m128i*)dst);
+        __m128i hidden = _mm_cmpeq_epi32(_mm_and_si128(s, alpha_mask), zero);
+        _mm_storeu_si128((__m128i*)dst, _mm_or_si128(_mm_and_si128(hidden, d), _mm_andnot_si128(hidden, s)));
+    }
+    if (count > 0) {
+        blit_masked_scalar(dst, src, count);
+    }
+}
+
+__attribute__((target("sse2")))
+static void blit_blend_sse2(u32* dst, const u32* src, i32 count) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i one = _mm_set1_epi16(1);
+    __m128i full = _mm_set1_epi16(256);
+    __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
     
-    for (i32 y = y1; y < y2; y++) {
-        for (i32 x = x1; x < x2; x++) {
-            if (color.a == 255) {
-                ctx->pixels[y * ctx->width + x] = packed;
-            } else {
-                ctx->pixels[y * ctx->width + x] = blend_colors(packed, ctx->pixels[y * ctx->width + x]);
-            }
-        }
+    /* Per pixel (s * (a + 1) + d * (256 - a)) >> 8; the two weights sum to 257,
+     * so the 16-bit lanes never overflow. Transparent pixels keep dst untouched. */
+    for (; count >= 4; count -= 4, dst += 4, src += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)src);
+        __m128i d = _mm_loadu_si128((const __m128i*)dst);
+        
+        __m128i s_lo = _mm_unpacklo_epi8(s, zero);
+        __m128i s_hi = _mm_unpackhi_epi8(s, zero);
+        __m128i a_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_lo, 0xFF), 0xFF);
+        __m128i a_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_hi, 0xFF), 0xFF);
+        
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(s_lo, _mm_add_epi16(a_lo, one)),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(full, a_lo)));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(s_hi, _mm_add_epi16(a_hi, one)),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(full, a_hi)));
+        __m128i blended = _mm_or_si128(_mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)), alpha_mask);
+        
+        __m128i hidden = _mm_cmpeq_epi32(_mm_and_si128(s, alpha_mask), zero);
+        _mm_storeu_si128((__m128i*)dst, _mm_or_si128(_mm_and_si128(hidden, d), _mm_andnot_si128(hidden, blended)));
+    }
+    if (count > 0) {
+        blit_blend_scalar(dst, src, count);
     }
 }
 
-void graphics_draw_circle(graphics_context_t* ctx, i32 cx, i32 cy, i32 radius, graphics_color_t color) {
-    if (!ctx || radius < 0) return;
+__attribute__((target("avx2")))
+static void blit_masked_avx2(u32* dst, const u32* src, i32 count) {
+    __m256i alpha_mask = _mm256_set1_epi32((int)0xFF000000);
+    __m256i zero = _mm256_setzero_si256();
     
-    /* Midpoint circle algorithm */
-    i32 x = radius;
-    i32 y = 0;
-    i32 err = 0;
+    for (; count >= 8; count -= 8, dst += 8, src += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)src);
+        __m256i d = _mm256_loadu_si256((const __m256i*)dst);
+        __m256i hidden = _mm256_cmpeq_epi32(_mm256_and_si256(s, alpha_mask), zero);
+        _mm256_storeu_si256((__m256i*)dst, _mm256_blendv_epi8(s, d, hidden));
+    }
+    if (count > 0) {
+        blit_masked_sse2(dst, src, count);
+    }
+}
+
+__attribute__((target("avx2")))
+static void blit_blend_avx2(u32* dst, const u32* src, i32 count) {
+    __m256i zero = _mm256_setzero_si256();
+    __m256i one = _mm256_set1_epi16(1);
+    __m256i full = _mm256_set1_epi16(256);
+    __m256i alpha_mask = _mm256_set1_epi32((int)0xFF000000);
     
-    while (x >= y) {
-        graphics_draw_pixel(ctx, cx + x, cy + y, color);
-        graphics_draw_pixel(ctx, cx + y, cy + x, color);
-        graphics_draw_pixel(ctx, cx - y, cy + x, color);
-        graphics_draw_pixel(ctx, cx - x, cy + y, color);
-        graphics_draw_pixel(ctx, cx - x, cy - y, color);
-        graphics_draw_pixel(ctx, cx - y, cy - x, color);
-        graphics_draw_pixel(ctx, cx + y, cy - x, color);
-        graphics_draw_pixel(ctx, cx + x, cy - y, color);
+    for (; count >= 8; count -= 8, dst += 8, src += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)src);
+        __m256i d = _mm256_loadu_si256((const __m256i*)dst);
         
-        if (err <= 0) {
-            y += 1;
-            err += 2 * y + 1;
-        }
-        if (err > 0) {
-            x -= 1;
-            err -= 2 * x + 1;
-        }
+        __m256i s_lo = _mm256_unpacklo_epi8(s, zero);
+        __m256i s_hi = _mm256_unpackhi_epi8(s, zero);
+        __m256i a_lo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_lo, 0xFF), 0xFF);
+        __m256i a_hi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_hi, 0xFF), 0xFF);
+        
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(s_lo, _mm256_add_epi16(a_lo, one)),
+                                      _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_sub_epi16(full, a_lo)));
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(s_hi, _mm256_add_epi16(a_hi, one)),
+                                      _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_sub_epi16(full, a_hi)));
+        __m256i blended = _mm256_or_si256(_mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8)), alpha_mask);
+        
+        __m256i hidden = _mm256_cmpeq_epi32(_mm256_and_si256(s, alpha_mask), zero);
+        _mm256_storeu_si256((__m256i*)dst, _mm256_blendv_epi8(blended, d, hidden));
+    }
+    if (count > 0) {
+        blit_blend_sse2(dst, src, count);
     }
 }
 
-void graphics_fill_circle(graphics_context_t* ctx, i32 cx, i32 cy, i32 radius, graphics_color_t color) {
-    if (!ctx || radius < 0) return;
+__attribute__((target("sse2")))
+static void span_blend_premul_sse2(u32* dst, i32 count, u32 color) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i src = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero);
+    __m128i inv = _mm_set1_epi16((short)(256 - (color >> 24)));
     
-    /* Scanline circle fill */
-    i32 x = radius;
-    i32 y = 0;
-    i32 err = 0;
+    for (; count >= 4; count -= 4, dst += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i*)dst);
+        __m128i lo = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv), 8), src);
+        __m128i hi = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv), 8), src);
+        _mm_storeu_si128((__m128i*)dst, _mm_packus_epi16(lo, hi));
+    }
+    if (count > 0) {
+        span_blend_premul_scalar(dst, count, color);
+    }
+}
+
+__attribute__((target("sse2")))
+static void blit_blend_premul_sse2(u32* dst, const u32* src, i32 count) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i full = _mm_set1_epi16(256);
     
-    while (x >= y) {
-        /* Draw horizontal lines */
-        for (i32 i = cx - x; i <= cx + x; i++) {
-            graphics_draw_pixel(ctx, i, cy + y, color);
-            graphics_draw_pixel(ctx, i, cy - y, color);
-        }
-        for (i32 i = cx - y; i <= cx + y; i++) {
-            graphics_draw_pixel(ctx, i, cy + x, color);
-            graphics_draw_pixel(ctx, i, cy - x, color);
-        }
-        
-        if (err <= 0) {
-            y += 1;
-            err += 2 * y + 1;
-        }
-        if (err > 0) {
-            x -= 1;
-            err -= 2 * x + 1;
-        }
+    for (; count >= 4; count -= 4, dst += 4, src += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)src);
+        __m128i d = _mm_loadu_si128((const __m128i*)dst);
+        __m128i s_lo = _mm_unpacklo_epi8(s, zero);
+        __m128i s_hi = _mm_unpackhi_epi8(s, zero);
+        __m128i inv_lo = _mm_sub_epi16(full, _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_lo, 0xFF), 0xFF));
+        __m128i inv_hi = _mm_sub_epi16(full, _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_hi, 0xFF), 0xFF));
+        __m128i lo = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv_lo), 8), s_lo);
+        __m128i hi = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv_hi), 8), s_hi);
+        _mm_storeu_si128((__m128i*)dst, _mm_packus_epi16(lo, hi));
+    }
+    if (count > 0) {
+        blit_blend_premul_scalar(dst, src, count);
     }
 }
 
-void graphics_draw_triangle(graphics_context_t* ctx, i32 x1, i32 y1, i32 x2, i32 y2, i32 x3, i32 y3, graphics_color_t color) {
-    if (!ctx) return;
+__attribute__((target("avx2")))
+static void span_blend_premul_avx2(u32* dst, i32 count, u32 color) {
+    __m256i zero = _mm256_setzero_si256();
+    __m256i src = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)color), zero);
+    __m256i inv = _mm256_set1_epi16((short)(256 - (color >> 24)));
     
-    graphics_draw_line(ctx, x1, y1, x2, y2, color);
-    graphics_draw_line(ctx, x2, y2, x3, y3, color);
-    graphics_draw_line(ctx, x3, y3, x1, y1, color);
+    for (; count >= 8; count -= 8, dst += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i*)dst);
+        __m256i lo = _mm256_add_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), inv), 8), src);
+        __m256i hi = _mm256_add_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), inv), 8), src);
+        _mm256_storeu_si256((__m256i*)dst, _mm256_packus_epi16(lo, hi));
+    }
+    if (count > 0) {
+        span_blend_premul_sse2(dst, count, color);
+    }
 }
 
-void graphics_fill_triangle(graphics_context_t* ctx, i32 x1, i32 y1, i32 x2, i32 y2, i32 x3, i32 y3, graphics_color_t color) {
-    if (!ctx) return;
+__attribute__((target("avx2")))
+static void blit_blend_premul_avx2(u32* dst, const u32* src, i32 count) {
+    __m256i zero = _mm256_setzero_si256();
+    __m256i full = _mm256_set1_epi16(256);
     
-    /* Simple scanline triangle fill */
-    /* Sort vertices by y-coordinate */
-    if (y1 > y2) { i32 tmp = y1; y1 = y2; y2 = tmp; tmp = x1; x1 = x2; x2 = tmp; }
-    if (y1 > y3) { i32 tmp = y1; y1 = y3; y3 = tmp; tmp = x1; x1 = x3; x3 = tmp; }
-    if (y2 > y3) { i32 tmp = y2; y2 = y3; y3 = tmp; tmp = x2; x2 = x3; x3 = tmp; }
+    for (; count >= 8; count -= 8, dst += 8, src += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)src);
+        __m256i d = _mm256_loadu_si256((const __m256i*)dst);
+        __m256i s_lo = _mm256_unpacklo_epi8(s, zero);
+        __m256i s_hi = _mm256_unpackhi_epi8(s, zero);
+        __m256i inv_lo = _mm256_sub_epi16(full, _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_lo, 0xFF), 0xFF));
+        __m256i inv_hi = _mm256_sub_epi16(full, _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_hi, 0xFF), 0xFF));
+        __m256i lo = _mm256_add_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), inv_lo), 8), s_lo);
+        __m256i hi = _mm256_add_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), inv_hi), 8), s_hi);
+        _mm256_storeu_si256((__m256i*)dst, _mm256_packus_epi16(lo, hi));
+    }
+    if (count > 0) {
+        blit_blend_premul_sse2(dst, src, count);
+    }
+}
+
+__attribute__((target("sse2")))
+static void scale_bilinear_sse2(u32* dst, const u32* row0, const u32* row1, i32 count, i32 u, i32 du, u32 fy, i32 max_x) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i wy0 = _mm_set1_epi16((short)(256 - fy));
+    __m128i wy1 = _mm_set1_epi16((short)fy);
     
-    /* Scanline fill */
-    for (i32 y = y1; y <= y3; y++) {
-        i32 xa, xb;
-        
-        if (y < y2) {
-            xa = y1 != y2 ? x1 + (x2 - x1) * (y - y1) / (y2 - y1) : x1;
-        } else {
-            xa = y2 != y3 ? x2 + (x3 - x2) * (y - y2) / (y3 - y2) : x2;
-        }
-        
-        xb = y1 != y3 ? x1 + (x3 - x1) * (y - y1) / (y3 - y1) : x1;
+    /* Each pixel's two texels share one register: lanes 0-3 left, 4-7 right */
+    for (i32 i = 0; i < count; i++, u += du) {
+        u32 fx;
+        i32 x0 = bilinear_texel(u, max_x, &fx);
+        i32 x1 = ENGINE_MIN(x0 + 1, max_x);
         
-        if (xa > xb) { i32 tmp = xa; xa = xb; xb = tmp; }
+        __m128i top = _mm_unpacklo_epi32(_mm_cvtsi32_si128((int)row0[x0]), _mm_cvtsi32_si128((int)row0[x1]));
+        __m128i bottom = _mm_unpacklo_epi32(_mm_cvtsi32_si128((int)row1[x0]), _mm_cvtsi32_si128((int)row1[x1]));
+        __m128i v = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(top, zero), wy0),
+                                  _mm_mullo_epi16(_mm_unpacklo_epi8(bottom, zero), wy1));
+        v = _mm_srli_epi16(v, 8);
         
-        for (i32 x = xa; x <= xb; x++) {
-            graphics_draw_pixel(ctx, x, y, color);
-        }
+        __m128i wx = _mm_set_epi16((short)fx, (short)fx, (short)fx, (short)fx,
+                                   (short)(256 - fx), (short)(256 - fx), (short)(256 - fx), (short)(256 - fx));
+        v = _mm_mullo_epi16(v, wx);
+        v = _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_si128(v, 8)), 8);
+        dst[i] = (u32)_mm_cvtsi128_si32(_mm_packus_epi16(v, zero));
     }
 }
 
-/* Text rendering */
-graphics_font_t* graphics_get_default_font(void) {
-    return &g_default_font;
+__attribute__((target("sse2")))
+static void swizzle_bgra_sse2(u32* dst, const u8* src, i32 count) {
+    /* Swap bytes 0 and 2 of each pixel with shifts, SSE2 has no byte shuffle */
+    __m128i ga = _mm_set1_epi32((int)0xFF00FF00);
+    __m128i low = _mm_set1_epi32(0xFF);
+    
+    for (; count >= 4; count -= 4, dst += 4, src += 16) {
+        __m128i p = _mm_loadu_si128((const __m128i*)src);
+        __m128i r = _mm_and_si128(_mm_srli_epi32(p, 16), low);
+        __m128i b = _mm_slli_epi32(_mm_and_si128(p, low), 16);
+        _mm_storeu_si128((__m128i*)dst, _mm_or_si128(_mm_and_si128(p, ga), _mm_or_si128(r, b)));
+    }
+    if (count > 0) {
+        swizzle_bgra_scalar(dst, src, count);
+    }
 }
 
-void graphics_draw_text(graphics_context_t* ctx, const char* text, i32 x, i32 y, graphics_color_t color, graphics_font_t* font) {
-    if (!ctx || !text) return;
-    if (!font) font = &g_default_font;
+/* AVX2 implies SSSE3, so the AVX2 level can use byte shuffles */
+__attribute__((target("avx2")))
+static void swizzle_bgra_avx2(u32* dst, const u8* src, i32 count) {
+    __m256i mask = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                    2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
     
-    i32 start_x = x;
+    for (; count >= 8; count -= 8, dst += 8, src += 32) {
+        __m256i p = _mm256_loadu_si256((const __m256i*)src);
+        _mm256_storeu_si256((__m256i*)dst, _mm256_shuffle_epi8(p, mask));
+    }
+    if (count > 0) {
+        swizzle_bgra_scalar(dst, src, count);
+    }
+}
+
+__attribute__((target("avx2")))
+static void swizzle_bgr_avx2(u32* dst, const u8* src, i32 count) {
+    __m128i mask = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+    
+    /* Each step uses 12 of the 16 bytes loaded, so stop while a full load still fits */
+    for (; count >= 6; count -= 4, dst += 4, src += 12) {
+        __m128i p = _mm_loadu_si128((const __m128i*)src);
+        _mm_storeu_si128((__m128i*)dst, _mm_or_si128(_mm_shuffle_epi8(p, mask), alpha));
+    }
+    if (count > 0) {
+        swizzle_bgr_scalar(dst, src, count);
+    }
+}
+
+static const graphics_span_ops_t g_span_ops_sse2 = {
+    "sse2", span_fill_sse2, span_blend_sse2, blit_masked_sse2, blit_blend_sse2,
+    span_blend_premul_sse2, blit_blend_premul_sse2, scale_bilinear_sse2,
+    swizzle_bgra_sse2, swizzle_bgr_scalar
+};
+
+static const graphics_span_ops_t g_span_ops_avx2 = {
+    "avx2", span_fill_avx2, span_blend_avx2, blit_masked_avx2, blit_blend_avx2,
+    span_blend_premul_avx2, blit_blend_premul_avx2, scale_bilinear_sse2,
+    swizzle_bgra_avx2, swizzle_bgr_avx2
+};
+
+/* Helper: AVX2 needs both the CPU feature and OS support for YMM state */
+static bool cpu_has_avx2(void) {
+    u32 eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+    if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) return false;
+    
+    u32 xcr0_lo, xcr0_hi;
+    __asm__ volatile("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    (void)xcr0_hi;
+    if ((xcr0_lo & 6) != 6) return false;
+    
+    if (__get_cpuid_max(0, NULL) < 7) return false;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return (ebx & bit_AVX2) != 0;
+}
+
+static bool cpu_has_sse2(void) {
+    u32 eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+    return (edx & bit_SSE2) != 0;
+}
+#endif
+
+static const graphics_span_ops_t* g_span_ops = NULL;
+
+/* Helper: Pick span kernels once. ENGINE_GRAPHICS_SIMD=scalar|sse2|avx2 caps the level. */
+static const graphics_span_ops_t* select_span_ops(void) {
+    if (g_span_ops) return g_span_ops;
+    
+    const graphics_span_ops_t* ops = &g_span_ops_scalar;
+#ifdef GRAPHICS_HAVE_X86_SIMD
+    const char* limit = getenv("ENGINE_GRAPHICS_SIMD");
+    bool allow_sse2 = !limit || strcmp(limit, "scalar") != 0;
+    bool allow_avx2 = allow_sse2 && (!limit || strcmp(limit, "sse2") != 0);
+    
+    if (allow_avx2 && cpu_has_avx2()) {
+        ops = &g_span_ops_avx2;
+    } else if (allow_sse2 && cpu_has_sse2()) {
+        ops = &g_span_ops_sse2;
+    }
+#endif
+    
+    g_span_ops = ops;
+    ENGINE_LOG_INFO("Graphics span kernels: %s", ops->name);
+    return ops;
+}
+
+/* Helper: Pointer to the first pixel of row y */
+static inline u32* ctx_row(const graphics_context_t* ctx, i32 y) {
+    return ctx->pixels + (size_t)y * ctx->pitch;
+}
+
+/* Span writer: fill or blend `count` pixels with one packed color */
+typedef void (*span_fn_t)(u32* dst, i32 count, u32 color);
+
+/* Clip box resolved once per primitive (half-open: x1 <= x < x2) */
+typedef struct {
+    i32 x1, y1, x2, y2;
+} clip_box_t;
+
+/* Helper: Intersect the clip rect with the context bounds. Returns false if nothing is visible. */
+static bool get_clip_box(const graphics_context_t* ctx, clip_box_t* box) {
+    box->x1 = 0;
+    box->y1 = 0;
+    box->x2 = ctx->width;
+    box->y2 = ctx->height;
+    
+    if (ctx->clipping_enabled) {
+        const graphics_rect_t* r = &ctx->clip_rect;
+        if (r->x > box->x1) box->x1 = r->x;
+        if (r->y > box->y1) box->y1 = r->y;
+        if (r->x + r->width < box->x2) box->x2 = r->x + r->width;
+        if (r->y + r->height < box->y2) box->y2 = r->y + r->height;
+    }
+    
+    return box->x1 < box->x2 && box->y1 < box->y2;
+}
+
+/* Guards building and dropping image mip levels */
+static pthread_mutex_t g_mip_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Helper: Drop an image's mip levels after its pixels change */
+static void image_drop_mip(graphics_image_t* image) {
+    if (!__atomic_load_n(&image->mip, __ATOMIC_ACQUIRE)) return;
+    
+    pthread_mutex_lock(&g_mip_lock);
+    graphics_image_t* mip = image->mip;
+    __atomic_store_n(&image->mip, NULL, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&g_mip_lock);
+    graphics_destroy_image(mip);
+}
+
+/* Helper: Ready a view's pixels for a write. Views skip their ancestors'
+ * deferred queues, so those land first, and mips of a drawn-into image go stale. */
+static void view_sync(graphics_context_t* ctx) {
+    for (graphics_context_t* c = ctx; c; c = c->parent) {
+        if (c != ctx) graphics_flush(c);
+        if (c->image) image_drop_mip(c->image);
+    }
+}
+
+/* Damage tracking
+ * Draw calls add their clipped bounds to a short rect list. A new rect absorbs
+ * any rect it overlaps or that its union costs no extra area to include; when
+ * the list is full the cheapest pair to join is merged instead. */
+static inline i64 box_area(i32 x1, i32 y1, i32 x2, i32 y2) {
+    return (i64)(x2 - x1) * (y2 - y1);
+}
+
+static void damage_add_box(graphics_context_t* ctx, i32 x1, i32 y1, i32 x2, i32 y2) {
+    if (!ctx->damage_tracking) return;
+    
+    x1 = ENGINE_MAX(x1, 0);
+    y1 = ENGINE_MAX(y1, 0);
+    x2 = ENGINE_MIN(x2, ctx->width);
+    y2 = ENGINE_MIN(y2, ctx->height);
+    if (x1 >= x2 || y1 >= y2) return;
+    
+    /* Immediate draws write now; deferred ones sync when flushed */
+    if ((ctx->parent || ctx->image) && !ctx->deferred) view_sync(ctx);
+    
+    /* Drawing through a view changes the parent's pixels too */
+    if (ctx->parent) {
+        damage_add_box(ctx->parent, x1 + ctx->parent_x, y1 + ctx->parent_y, x2 + ctx->parent_x, y2 + ctx->parent_y);
+    }
+    
+    /* Already covered */
+    for (i32 i = 0; i < ctx->damage_count; i++) {
+        const graphics_rect_t* r = &ctx->damage[i];
+        if (x1 >= r->x && y1 >= r->y && x2 <= r->x + r->width && y2 <= r->y + r->height) return;
+    }
+    
+    for (;;) {
+        i32 best = -1;
+        i64 best_cost = 0;
+        
+        for (i32 i = 0; i < ctx->damage_count; i++) {
+            const graphics_rect_t* r = &ctx->damage[i];
+            i32 rx2 = r->x + r->width;
+            i32 ry2 = r->y + r->height;
+            
+            /* Extra area the union would present that neither rect covers */
+            i64 cost = box_area(ENGINE_MIN(x1, r->x), ENGINE_MIN(y1, r->y), ENGINE_MAX(x2, rx2), ENGINE_MAX(y2, ry2)) -
+                       box_area(x1, y1, x2, y2) - box_area(r->x, r->y, rx2, ry2);
+            bool overlaps = x1 < rx2 && r->x < x2 && y1 < ry2 && r->y < y2;
+            if (overlaps || cost <= 0 || ctx->damage_count == GRAPHICS_MAX_DAMAGE_RECTS) {
+                if (best < 0 || cost < best_cost) {
+                    best = i;
+                    best_cost = cost;
+                }
+                if (overlaps || cost <= 0) break;
+            }
+        }
+        
+        if (best < 0) break;
+        
+        /* Absorb the rect and look again, the grown rect may now reach others */
+        const graphics_rect_t* r = &ctx->damage[best];
+        x2 = ENGINE_MAX(x2, r->x + r->width);
+        y2 = ENGINE_MAX(y2, r->y + r->height);
+        x1 = ENGINE_MIN(x1, r->x);
+        y1 = ENGINE_MIN(y1, r->y);
+        ctx->damage[best] = ctx->damage[--ctx->damage_count];
+    }
+    
+    ctx->damage[ctx->damage_count++] = graphics_rect(x1, y1, x2 - x1, y2 - y1);
+}
+
+/* Helper: Mark the bounds [x1, x2) x [y1, y2) of an immediate draw as damaged, under the current clip */
+static void mark_damage(graphics_context_t* ctx, i32 x1, i32 y1, i32 x2, i32 y2) {
+    clip_box_t clip;
+    if (!ctx->damage_tracking || !get_clip_box(ctx, &clip)) return;
+    damage_add_box(ctx, ENGINE_MAX(x1, clip.x1), ENGINE_MAX(y1, clip.y1), ENGINE_MIN(x2, clip.x2), ENGINE_MIN(y2, clip.y2));
+}
+
+/* Helper: Span writer for a color, or NULL if the color is fully transparent */
+static inline span_fn_t select_span_fn(const graphics_context_t* ctx, graphics_color_t color) {
+    if (color.a == 0) return NULL;
+    if (color.a == 255) return ctx->spans->fill;
+    return (ctx->format == GRAPHICS_FORMAT_PREMULTIPLIED) ? ctx->spans->blend_premul : ctx->spans->blend;
+}
+
+/* Helper: Pack a color in the context's pixel format */
+static inline u32 ctx_pack(const graphics_context_t* ctx, graphics_color_t color) {
+    return convert_pixel(pack_color(color), GRAPHICS_FORMAT_RGBA, ctx->format);
+}
+
+/* Helper: Blend one pixel already in the context's format */
+static inline u32 ctx_blend(const graphics_context_t* ctx, u32 src, u32 dst) {
+    return (ctx->format == GRAPHICS_FORMAT_PREMULTIPLIED) ? blend_premultiplied(src, dst) : blend_colors(src, dst);
+}
+
+/* Helper: Clip the span [x1, x2) on row y and hand it to the span writer */
+static inline void draw_span(const graphics_context_t* ctx, const clip_box_t* clip, i32 y, i32 x1, i32 x2, u32 packed, span_fn_t span) {
+    if (y < clip->y1 || y >= clip->y2) return;
+    if (x1 < clip->x1) x1 = clip->x1;
+    if (x2 > clip->x2) x2 = clip->x2;
+    if (x1 >= x2) return;
+    span(ctx_row(ctx, y) + x1, x2 - x1, packed);
+}
+
+/* Deferred rendering
+ * In deferred mode draw calls are recorded instead of executed. On flush the
+ * commands are binned into GRAPHICS_TILE_SIZE tiles and each tile replays its
+ * commands, in order, on a worker thread with the clip narrowed to the tile.
+ * Every primitive rasterizes in absolute coordinates, so the result is the
+ * same as the immediate path pixel for pixel.
+ */
+#define GRAPHICS_TILE_SIZE 64
+#define GRAPHICS_MAX_THREADS 64
+
+typedef enum {
+    GRAPHICS_CMD_CLEAR,
+    GRAPHICS_CMD_PIXEL,
+    GRAPHICS_CMD_LINE,
+    GRAPHICS_CMD_RECT,
+    GRAPHICS_CMD_FILL_RECT,
+    GRAPHICS_CMD_CIRCLE,
+    GRAPHICS_CMD_FILL_CIRCLE,
+    GRAPHICS_CMD_FILL_TRIANGLE,
+    GRAPHICS_CMD_FILL_TRIANGLE_EX,
+    GRAPHICS_CMD_TEXT,
+    GRAPHICS_CMD_IMAGE,
+    GRAPHICS_CMD_IMAGE_SCALED,
+    GRAPHICS_CMD_LAYER,
+    GRAPHICS_CMD_SPRITE,
+} graphics_cmd_type_t;
+
+/* Recorded draw call */
+typedef struct {
+    graphics_cmd_type_t type;
+    graphics_color_t color;
+    graphics_rect_t clip;     /* Effective clip box when recorded */
+    graphics_rect_t bounds;   /* Conservative screen bounds, already clipped */
+    union {
+        struct { i32 x1, y1, x2, y2, x3, y3; } points;
+        graphics_rect_t rect;
+        struct { i32 cx, cy, radius; } circle;
+        struct { graphics_vertex_t v[3]; u32 flags; } triangle;
+        struct { i32 x, y; u32 offset; graphics_font_t* font; } text;
+        struct { const graphics_image_t* image; graphics_rect_t dest; u32 filter; } image;
+        struct { graphics_context_t* layer; i32 x, y; } layer;
+        struct { const graphics_atlas_t* atlas; i32 sprite, x, y; } sprite;
+    } data;
+} graphics_cmd_t;
+
+/* Recorded commands plus their text storage */
+typedef struct graphics_cmd_list {
+    graphics_cmd_t* cmds;
+    i32 count;
+    i32 capacity;
+    char* text;
+    u32 text_size;
+    u32 text_capacity;
+} graphics_cmd_list_t;
+
+/* Per-context deferred state */
+struct graphics_deferred {
+    graphics_cmd_list_t list;
+    
+    /* Tile bins: indices of the commands touching each tile, in order */
+    i32 tiles_x, tiles_y;
+    i32* bin_start;      /* tiles_x * tiles_y + 1 offsets into bin_cmds */
+    i32 bin_capacity;
+    i32* bin_cmds;
+    i32 bin_cmds_capacity;
+};
+
+/* Helper: Append a command, growing the list. Returns NULL on allocation failure. */
+static graphics_cmd_t* cmd_list_push(graphics_cmd_list_t* list) {
+    if (list->count == list->capacity) {
+        i32 capacity = list->capacity ? list->capacity * 2 : 256;
+        graphics_cmd_t* cmds = (graphics_cmd_t*)realloc(list->cmds, (size_t)capacity * sizeof(graphics_cmd_t));
+        if (!cmds) {
+            ENGINE_LOG_ERROR("Failed to grow graphics command list");
+            return NULL;
+        }
+        list->cmds = cmds;
+        list->capacity = capacity;
+    }
+    return &list->cmds[list->count++];
+}
+
+/* Helper: Copy a string into the list's text storage. Returns its offset or -1. */
+static i64 cmd_list_push_text(graphics_cmd_list_t* list, const char* text) {
+    u32 len = (u32)strlen(text) + 1;
+    if (list->text_size + len > list->text_capacity) {
+        u32 capacity = list->text_capacity ? list->text_capacity : 4096;
+        while (list->text_size + len > capacity) capacity *= 2;
+        char* storage = (char*)realloc(list->text, capacity);
+        if (!storage) {
+            ENGINE_LOG_ERROR("Failed to grow graphics text storage");
+            return -1;
+        }
+        list->text = storage;
+        list->text_capacity = capacity;
+    }
+    
+    u32 offset = list->text_size;
+    memcpy(list->text + offset, text, len);
+    list->text_size += len;
+    return offset;
+}
+
+static void cmd_list_free(graphics_cmd_list_t* list) {
+    free(list->cmds);
+    free(list->text);
+    memset(list, 0, sizeof(*list));
+}
+
+/* Helper: Record a command with bounds [x1, x2) x [y1, y2) under an explicit clip box.
+ * Returns the command to fill in, or NULL when nothing needs recording (culled or out of memory). */
+static graphics_cmd_t* defer_cmd_clipped(graphics_context_t* ctx, const clip_box_t* clip_box, graphics_cmd_type_t type,
+                                         i32 x1, i32 y1, i32 x2, i32 y2, graphics_color_t color) {
+    clip_box_t clip = *clip_box;
+    
+    /* Bounds are half-open [x1, x2) x [y1, y2), clipped */
+    x1 = ENGINE_MAX(x1, clip.x1);
+    y1 = ENGINE_MAX(y1, clip.y1);
+    x2 = ENGINE_MIN(x2, clip.x2);
+    y2 = ENGINE_MIN(y2, clip.y2);
+    if (x1 >= x2 || y1 >= y2) return NULL;
+    
+    graphics_cmd_t* cmd = cmd_list_push(ctx->record);
+    if (!cmd) return NULL;
+    
+    cmd->type = type;
+    cmd->color = color;
+    cmd->clip = graphics_rect(clip.x1, clip.y1, clip.x2 - clip.x1, clip.y2 - clip.y1);
+    cmd->bounds = graphics_rect(x1, y1, x2 - x1, y2 - y1);
+    
+    /* Deferred draws damage the context now; display list recordings draw nothing */
+    if (ctx->deferred && ctx->record == &ctx->deferred->list) {
+        damage_add_box(ctx, x1, y1, x2, y2);
+    }
+    return cmd;
+}
+
+/* Helper: Record a command under the context's current clip */
+static graphics_cmd_t* defer_cmd(graphics_context_t* ctx, graphics_cmd_type_t type, i32 x1, i32 y1, i32 x2, i32 y2, graphics_color_t color) {
+    clip_box_t clip;
+    if (!get_clip_box(ctx, &clip)) return NULL;
+    return defer_cmd_clipped(ctx, &clip, type, x1, y1, x2, y2, color);
+}
+
+/* Color creation */
+graphics_color_t graphics_rgb(u8 r, u8 g, u8 b) {
+    graphics_color_t c = {r, g, b, 255};
+    return c;
+}
+
+graphics_color_t graphics_rgba(u8 r, u8 g, u8 b, u8 a) {
+    graphics_color_t c = {r, g, b, a};
+    return c;
+}
+
+graphics_color_t graphics_hex(u32 hex) {
+    graphics_color_t c;
+    c.r = (hex >> 16) & 0xFF;
+    c.g = (hex >> 8) & 0xFF;
+    c.b = hex & 0xFF;
+    c.a = 255;
+    return c;
+}
+
+/* Context management */
+/* Helper: Set up a context over a pixel buffer it may or may not own */
+static graphics_context_t* context_init(u32* pixels, i32 width, i32 height, i32 pitch, bool owns_pixels) {
+    graphics_context_t* ctx = (graphics_context_t*)malloc(sizeof(graphics_context_t));
+    if (!ctx) {
+        ENGINE_LOG_ERROR("Failed to allocate graphics context");
+        return NULL;
+    }
+    
+    ctx->pixels = pixels;
+    ctx->width = width;
+    ctx->height = height;
+    ctx->pitch = pitch;
+    ctx->owns_pixels = owns_pixels;
+    ctx->parent = NULL;
+    ctx->image = NULL;
+    ctx->parent_x = 0;
+    ctx->parent_y = 0;
+    ctx->clipping_enabled = false;
+    ctx->clip_rect = graphics_rect(0, 0, width, height);
+    ctx->spans = select_span_ops();
+    ctx->deferred = NULL;
+    ctx->record = NULL;
+    ctx->record_saved = NULL;
+    ctx->damage_tracking = true;
+    ctx->damage_count = 0;
+    damage_add_box(ctx, 0, 0, width, height);
+    ctx->format = GRAPHICS_FORMAT_RGBA;
+    return ctx;
+}
+
+graphics_context_t* graphics_create_context(i32 width, i32 height) {
+    if (width <= 0 || height <= 0) {
+        ENGINE_LOG_ERROR("Invalid context dimensions");
+        return NULL;
+    }
+    
+    u32* pixels = (u32*)calloc(width * height, sizeof(u32));
+    if (!pixels) {
+        ENGINE_LOG_ERROR("Failed to allocate pixel buffer");
+        return NULL;
+    }
+    
+    graphics_context_t* ctx = context_init(pixels, width, height, width, true);
+    if (!ctx) {
+        free(pixels);
+        return NULL;
+    }
+    
+    ENGINE_LOG_INFO("Graphics context created: %dx%d", width, height);
+    return ctx;
+}
+
+graphics_context_t* graphics_create_context_from_pixels(u32* pixels, i32 width, i32 height, i32 pitch) {
+    if (!pixels || width <= 0 || height <= 0 || pitch < width * (i32)sizeof(u32) || pitch % sizeof(u32) != 0) {
+        ENGINE_LOG_ERROR("Invalid pixel buffer: %dx%d, pitch %d", width, height, pitch);
+        return NULL;
+    }
+    
+    return context_init(pixels, width, height, pitch / (i32)sizeof(u32), false);
+}
+
+/* Helper: Clamp an optional rect to width x height, false if nothing is left */
+static bool view_rect(const graphics_rect_t* rect, i32 width, i32 height, graphics_rect_t* out) {
+    graphics_rect_t r = rect ? *rect : graphics_rect(0, 0, width, height);
+    i32 x1 = ENGINE_MAX(r.x, 0);
+    i32 y1 = ENGINE_MAX(r.y, 0);
+    i32 x2 = ENGINE_MIN(r.x + r.width, width);
+    i32 y2 = ENGINE_MIN(r.y + r.height, height);
+    if (x1 >= x2 || y1 >= y2) {
+        ENGINE_LOG_ERROR("View rect is empty");
+        return false;
+    }
+    
+    *out = graphics_rect(x1, y1, x2 - x1, y2 - y1);
+    return true;
+}
+
+graphics_context_t* graphics_create_view(graphics_context_t* parent, const graphics_rect_t* rect) {
+    if (!parent) return NULL;
+    
+    graphics_rect_t r;
+    if (!view_rect(rect, parent->width, parent->height, &r)) return NULL;
+    
+    graphics_context_t* ctx = context_init(parent->pixels + (size_t)r.y * parent->pitch + r.x,
+                                           r.width, r.height, parent->pitch, false);
+    if (!ctx) return NULL;
+    
+    ctx->format = parent->format;
+    ctx->parent = parent;
+    ctx->parent_x = r.x;
+    ctx->parent_y = r.y;
+    return ctx;
+}
+
+graphics_context_t* graphics_create_image_view(graphics_image_t* image, const graphics_rect_t* rect) {
+    if (!image) return NULL;
+    
+    graphics_rect_t r;
+    if (!view_rect(rect, image->width, image->height, &r)) return NULL;
+    
+    graphics_context_t* ctx = context_init(image->pixels + (size_t)r.y * image->pitch + r.x,
+                                           r.width, r.height, image->pitch, false);
+    if (!ctx) return NULL;
+    
+    /* Drawing can change any pixel's alpha; each write drops downscaled copies */
+    ctx->format = image->format;
+    ctx->image = image;
+    image->opacity = GRAPHICS_OPACITY_ALPHA;
+    return ctx;
+}
+
+void graphics_destroy_context(graphics_context_t* ctx) {
+    if (!ctx) return;
+    
+    /* Pending commands are dropped, not rendered */
+    if (ctx->deferred) {
+        ctx->deferred->list.count = 0;
+        graphics_end_deferred(ctx);
+    }
+    
+    if (ctx->owns_pixels) {
+        free(ctx->pixels);
+    }
+    bool view = !ctx->owns_pixels;
+    free(ctx);
+    if (!view) {
+        ENGINE_LOG_INFO("Graphics context destroyed");
+    }
+}
+
+void graphics_set_format(graphics_context_t* ctx, graphics_format_t format) {
+    if (!ctx || ctx->format == format) return;
+    
+    graphics_flush(ctx);
+    view_sync(ctx);
+    for (i32 y = 0; y < ctx->height; y++) {
+        convert_pixels(ctx_row(ctx, y), (size_t)ctx->width, ctx->format, format);
+    }
+    ctx->format = format;
+    damage_add_box(ctx, 0, 0, ctx->width, ctx->height);
+}
+
+graphics_format_t graphics_get_format(const graphics_context_t* ctx) {
+    return ctx ? ctx->format : GRAPHICS_FORMAT_RGBA;
+}
+
+i32 graphics_get_width(const graphics_context_t* ctx) {
+    return ctx ? ctx->width : 0;
+}
+
+i32 graphics_get_height(const graphics_context_t* ctx) {
+    return ctx ? ctx->height : 0;
+}
+
+i32 graphics_get_pitch(const graphics_context_t* ctx) {
+    return ctx ? ctx->pitch * (i32)sizeof(u32) : 0;
+}
+
+void graphics_resize(graphics_context_t* ctx, i32 width, i32 height) {
+    if (!ctx || width <= 0 || height <= 0) return;
+    
+    if (!ctx->owns_pixels) {
+        ENGINE_LOG_WARN("Cannot resize a context that does not own its pixels");
+        return;
+    }
+    
+    graphics_flush(ctx);
+    
+    u32* new_pixels = (u32*)calloc(width * height, sizeof(u32));
+    if (!new_pixels) {
+        ENGINE_LOG_ERROR("Failed to resize graphics context");
+        return;
+    }
+    
+    free(ctx->pixels);
+    ctx->pixels = new_pixels;
+    ctx->width = width;
+    ctx->height = height;
+    ctx->pitch = width;
+    ctx->clip_rect = graphics_rect(0, 0, width, height);
+    ctx->damage_count = 0;
+    damage_add_box(ctx, 0, 0, width, height);
+}
+
+/* Rendering control */
+void graphics_clear(graphics_context_t* ctx, graphics_color_t color) {
+    if (!ctx) return;
+    
+    if (ctx->record) {
+        /* A clear overwrites everything recorded so far, and ignores the clip rect */
+        clip_box_t full = { 0, 0, ctx->width, ctx->height };
+        ctx->record->count = 0;
+        ctx->record->text_size = 0;
+        defer_cmd_clipped(ctx, &full, GRAPHICS_CMD_CLEAR, 0, 0, ctx->width, ctx->height, color);
+        return;
+    }
+    
+    damage_add_box(ctx, 0, 0, ctx->width, ctx->height);
+    ENGINE_PROFILE_BEGIN("graphics_clear");
+    
+    /* A contiguous buffer clears as one span */
+    u32 packed = ctx_pack(ctx, color);
+    if (ctx->pitch == ctx->width) {
+        ctx->spans->fill(ctx->pixels, ctx->width * ctx->height, packed);
+    } else {
+        for (i32 y = 0; y < ctx->height; y++) {
+            ctx->spans->fill(ctx_row(ctx, y), ctx->width, packed);
+        }
+    }
+    ENGINE_PROFILE_END();
+}
+
+void graphics_set_clip_rect(graphics_context_t* ctx, const graphics_rect_t* rect) {
+    if (!ctx || !rect) return;
+    
+    ctx->clip_rect = *rect;
+    ctx->clipping_enabled = true;
+}
+
+void graphics_clear_clip_rect(graphics_context_t* ctx) {
+    if (!ctx) return;
+    
+    ctx->clip_rect = graphics_rect(0, 0, ctx->width, ctx->height);
+    ctx->clipping_enabled = false;
+}
+
+/* Drawing primitives */
+void graphics_draw_pixel(graphics_context_t* ctx, i32 x, i32 y, graphics_color_t color) {
+    if (!ctx) return;
+    
+    if (ctx->record) {
+        graphics_cmd_t* cmd = defer_cmd(ctx, GRAPHICS_CMD_PIXEL, x, y, x + 1, y + 1, color);
+        if (cmd) {
+            cmd->data.points.x1 = x;
+            cmd->data.points.y1 = y;
+        }
+        return;
+    }
+    
+    clip_box_t clip;
+    if (!get_clip_box(ctx, &clip)) return;
+    if (x < clip.x1 || x >= clip.x2 || y < clip.y1 || y >= clip.y2) return;
+    
+    damage_add_box(ctx, x, y, x + 1, y + 1);
+    u32 packed = ctx_pack(ctx, color);
+    u32* dst = ctx_row(ctx, y) + x;
+    if (color.a == 255) {
+        *dst = packed;
+    } else {
+        *dst = ctx_blend(ctx, packed, *dst);
+    }
+}
+
+void graphics_draw_line(graphics_context_t* ctx, i32 x1, i32 y1, i32 x2, i32 y2, graphics_color_t color) {
+    if (!ctx) return;
+    
+    if (ctx->record) {
+        graphics_cmd_t* cmd = defer_cmd(ctx, GRAPHICS_CMD_LINE, ENGINE_MIN(x1, x2), ENGINE_MIN(y1, y2),
+                                        ENGINE_MAX(x1, x2) + 1, ENGINE_MAX(y1, y2) + 1, color);
+        if (cmd) {
+            cmd->data.points.x1 = x1;
+            cmd->data.points.y1 = y1;
+            cmd->data.points.x2 = x2;
+            cmd->data.points.y2 = y2;
+        }
+        return;
+    }
+    
+    clip_box_t clip;
+    span_fn_t span = select_span_fn(ctx, color);
+    if (!span || !get_clip_box(ctx, &clip)) return;
+    mark_damage(ctx, ENGINE_MIN(x1, x2), ENGINE_MIN(y1, y2), ENGINE_MAX(x1, x2) + 1, ENGINE_MAX(y1, y2) + 1);
+    
+    /* Trivial reject against the clip box */
+    if (ENGINE_MAX(x1, x2) < clip.x1 || ENGINE_MIN(x1, x2) >= clip.x2 ||
+        ENGINE_MAX(y1, y2) < clip.y1 || ENGINE_MIN(y1, y2) >= clip.y2) {
+        return;
+    }
+    
+    u32 packed = ctx_pack(ctx, color);
+    
+    /* Bresenham's line algorithm, emitting one span per run of pixels on the same row */
+    i32 dx = abs(x2 - x1);
+    i32 dy = abs(y2 - y1);
+    i32 sx = x1 < x2 ? 1 : -1;
+    i32 sy = y1 < y2 ? 1 : -1;
+    i32 err = dx - dy;
+    i32 run_x = x1;
+    i32 last_x = x1;
+    i32 row_y = y1;
+    
+    while (1) {
+        last_x = x1;
+        row_y = y1;
+        
+        if (x1 == x2 && y1 == y2) break;
+        
+        i32 e2 = 2 * err;
+        if (e2 > -dy) {
+            err -= dy;
+            x1 += sx;
+        }
+        if (e2 < dx) {
+            err += dx;
+            y1 += sy;
+        }
+        
+        if (y1 != row_y) {
+            draw_span(ctx, &clip, row_y, ENGINE_MIN(run_x, last_x), ENGINE_MAX(run_x, last_x) + 1, packed, span);
+            run_x = x1;
+        }
+    }
+    
+    draw_span(ctx, &clip, row_y, ENGINE_MIN(run_x, last_x), ENGINE_MAX(run_x, last_x) + 1, packed, span);
+}
+
+void graphics_draw_rect(graphics_context_t* ctx, const graphics_rect_t* rect, graphics_color_t color) {
+    if (!ctx || !rect || rect->width <= 0 || rect->height <= 0) return;
+    
+    if (ctx->record) {
+        graphics_cmd_t* cmd = defer_cmd(ctx, GRAPHICS_CMD_RECT, rect->x, rect->y,
+                                        rect->x + rect->width, rect->y + rect->height, color);
+        if (cmd) cmd->data.rect = *rect;
+        return;
+    }
+    
+    clip_box_t clip;
+    span_fn_t span = select_span_fn(ctx, color);
+    if (!span || !get_clip_box(ctx, &clip)) return;
+    mark_damage(ctx, rect->x, rect->y, rect->x + rect->width, rect->y + rect->height);
+    
+    u32 packed = ctx_pack(ctx, color);
+    i32 left = rect->x;
+    i32 right = rect->x + rect->width - 1;
+    i32 top = rect->y;
+    i32 bottom = rect->y + rect->height - 1;
+    
+    /* Top and bottom edges, then the sides between them, so corners are written once */
+    draw_span(ctx, &clip, top, left, right + 1, packed, span);
+    if (bottom != top) {
+        draw_span(ctx, &clip, bottom, left, right + 1, packed, span);
+    }
+    
+    i32 y_start = ENGINE_MAX(top + 1, clip.y1);
+    i32 y_end = ENGINE_MIN(bottom, clip.y2);
+    for (i32 y = y_start; y < y_end; y++) {
+        draw_span(ctx, &clip, y, left, left + 1, packed, span);
+        if (right != left) {
+            draw_span(ctx, &clip, y, right, right + 1, packed, span);
+        }
+    }
+}
+
+void graphics_fill_rect(graphics_context_t* ctx, const graphics_rect_t* rect, graphics_color_t color) {
+    if (!ctx || !rect) return;
+    
+    if (ctx->record) {
+        graphics_cmd_t* cmd = defer_cmd(ctx, GRAPHICS_CMD_FILL_RECT, rect->x, rect->y,
+                                        rect->x + rect->width, rect->y + rect->height, color);
+        if (cmd) cmd->data.rect = *rect;
+        return;
+    }
+    
+    clip_box_t clip;
+    span_fn_t span = select_span_fn(ctx, color);
+    if (!span || !get_clip_box(ctx, &clip)) return;
+    
+    i32 x1 = ENGINE_MAX(rect->x, clip.x1);
+    i32 y1 = ENGINE_MAX(rect->y, clip.y1);
+    i32 x2 = ENGINE_MIN(rect->x + rect->width, clip.x2);
+    i32 y2 = ENGINE_MIN(rect->y + rect->height, clip.y2);
+    
+    /* Early exit if clipped out entirely */
+    if (x1 >= x2 || y1 >= y2) return;
+    damage_add_box(ctx, x1, y1, x2, y2);
+    
+    u32 packed = ctx_pack(ctx, color);
+    for (i32 y = y1; y < y2; y++) {
+        span(ctx_row(ctx, y) + x1, x2 - x1, packed);
+    }
+}
+
+void graphics_draw_circle(graphics_context_t* ctx, i32 cx, i32 cy, i32 radius, graphics_color_t color) {
+    if (!ctx || radius < 0) return;
+    
+    if (ctx->record) {
+        graphics_cmd_t* cmd = defer_cmd(ctx, GRAPHICS_CMD_CIRCLE, cx - radius, cy - radius,
+                                        cx + radius + 1, cy + radius + 1, color);
+        if (cmd) {
+            cmd->data.circle.cx = cx;
+            cmd->data.circle.cy = cy;
+            cmd->data.circle.radius = radius;
+        }
+        return;
+    }
+    
+    mark_damage(ctx, cx - radius, cy - radius, cx + radius + 1, cy + radius + 1);
+    
+    /* The pixels below are inside the bounds just marked */
+    bool tracking = ctx->damage_tracking;
+    ctx->damage_tracking = false;
+    
+    /* Midpoint circle algorithm */
+    i32 x = radius;
+    i32 y = 0;
+    i32 err = 0;
+    
+    while (x >= y) {
+        graphics_draw_pixel(ctx, cx + x, cy + y, color);
+        graphics_draw_pixel(ctx, cx + y, cy + x, color);
+        graphics_draw_pixel(ctx, cx - y, cy + x, color);
+        graphics_draw_pixel(ctx, cx - x, cy + y, color);
+        graphics_draw_pixel(ctx, cx - x, cy - y, color);
+        graphics_draw_pixel(ctx, cx - y, cy - x, color);
+        graphics_draw_pixel(ctx, cx + y, cy - x, color);
+        graphics_draw_pixel(ctx, cx + x, cy - y, color);
+        
+        if (err <= 0) {
+            y += 1;
+            err += 2 * y + 1;
+        }
+        if (err > 0) {
+            x -= 1;
+            err -= 2 * x + 1;
+        }
+    }
+    
+    ctx->damage_tracking = tracking;
+}
+
+void graphics_fill_circle(graphics_context_t* ctx, i32 cx, i32 cy, i32 radius, graphics_color_t color) {
+    if (!ctx || radius < 0) return;
+    
+    if (ctx->record) {
+        graphics_cmd_t* cmd = defer_cmd(ctx, GRAPHICS_CMD_FILL_CIRCLE, cx - radius, cy - radius,
+                                        cx + radius + 1, cy + radius + 1, color);
+        if (cmd) {
+            cmd->data.circle.cx = cx;
+            cmd->data.circle.cy = cy;
+            cmd->data.circle.radius = radius;
+        }
+        return;
+    }
+    
+    clip_box_t clip;
+    span_fn_t span = select_span_fn(ctx, color);
+    if (!span || !get_clip_box(ctx, &clip)) return;
+    mark_damage(ctx, cx - radius, cy - radius, cx + radius + 1, cy + radius + 1);
+    if (cx + radius < clip.x1 || cx - radius >= clip.x2 ||
+        cy + radius < clip.y1 || cy - radius >= clip.y2) {
+        return;
+    }
+    
+    /* Midpoint circle: collect the widest half-width for each row offset first,
+     * so every row is emitted as exactly one span */
+    i32 stack_widths[256];
+    i32* half_width = stack_widths;
+    if (radius >= (i32)ENGINE_ARRAY_SIZE(stack_widths)) {
+        half_width = (i32*)malloc((size_t)(radius + 1) * sizeof(i32));
+        if (!half_width) return;
+    }
+    for (i32 i = 0; i <= radius; i++) {
+        half_width[i] = -1;
+    }
+    
+    i32 x = radius;
+    i32 y = 0;
+    i32 err = 0;
+    
+    while (x >= y) {
+        if (x > half_width[y]) half_width[y] = x;
+        if (y > half_width[x]) half_width[x] = y;
+        
+        if (err <= 0) {
+            y += 1;
+            err += 2 * y + 1;
+        }
+        if (err > 0) {
+            x -= 1;
+            err -= 2 * x + 1;
+        }
+    }
+    
+    u32 packed = ctx_pack(ctx, color);
+    for (i32 dy = 0; dy <= radius; dy++) {
+        i32 w = half_width[dy];
+        if (w < 0) continue;
+        draw_span(ctx, &clip, cy + dy, cx - w, cx + w + 1, packed, span);
+        if (dy != 0) {
+            draw_span(ctx, &clip, cy - dy, cx - w, cx + w + 1, packed, span);
+        }
+    }
+    
+    if (half_width != stack_widths) {
+        free(half_width);
+    }
+}
+
+void graphics_draw_triangle(graphics_context_t* ctx, i32 x1, i32 y1, i32 x2, i32 y2, i32 x3, i32 y3, graphics_color_t color) {
+    if (!ctx) return;
+    
+    graphics_draw_line(ctx, x1, y1, x2, y2, color);
+    graphics_draw_line(ctx, x2, y2, x3, y3, color);
+    graphics_draw_line(ctx, x3, y3, x1, y1, color);
+}
+
+void graphics_fill_triangle(graphics_context_t* ctx, i32 x1, i32 y1, i32 x2, i32 y2, i32 x3, i32 y3, graphics_color_t color) {
+    if (!ctx) return;
+    
+    if (ctx->record) {
+        graphics_cmd_t* cmd = defer_cmd(ctx, GRAPHICS_CMD_FILL_TRIANGLE,
+                                        ENGINE_MIN(x1, ENGINE_MIN(x2, x3)), ENGINE_MIN(y1, ENGINE_MIN(y2, y3)),
+                                        ENGINE_MAX(x1, ENGINE_MAX(x2, x3)) + 1, ENGINE_MAX(y1, ENGINE_MAX(y2, y3)) + 1, color);
+        if (cmd) {
+            cmd->data.points.x1 = x1;
+            cmd->data.points.y1 = y1;
+            cmd->data.points.x2 = x2;
+            cmd->data.points.y2 = y2;
+            cmd->data.points.x3 = x3;
+            cmd->data.points.y3 = y3;
+        }
+        return;
+    }
+    
+    clip_box_t clip;
+    span_fn_t span = select_span_fn(ctx, color);
+    if (!span || !get_clip_box(ctx, &clip)) return;
+    mark_damage(ctx, ENGINE_MIN(x1, ENGINE_MIN(x2, x3)), ENGINE_MIN(y1, ENGINE_MIN(y2, y3)),
+                ENGINE_MAX(x1, ENGINE_MAX(x2, x3)) + 1, ENGINE_MAX(y1, ENGINE_MAX(y2, y3)) + 1);
+    
+    /* Simple scanline triangle fill */
+    /* Sort vertices by y-coordinate */
+    if (y1 > y2) { i32 tmp = y1; y1 = y2; y2 = tmp; tmp = x1; x1 = x2; x2 = tmp; }
+    if (y1 > y3) { i32 tmp = y1; y1 = y3; y3 = tmp; tmp = x1; x1 = x3; x3 = tmp; }
+    if (y2 > y3) { i32 tmp = y2; y2 = y3; y3 = tmp; tmp = x2; x2 = x3; x3 = tmp; }
+    
+    u32 packed = ctx_pack(ctx, color);
+    
+    /* Scanline fill, restricted to the rows inside the clip box */
+    i32 y_start = ENGINE_MAX(y1, clip.y1);
+    i32 y_end = ENGINE_MIN(y3, clip.y2 - 1);
+    for (i32 y = y_start; y <= y_end; y++) {
+        i32 xa, xb;
+        
+        if (y < y2) {
+            xa = y1 != y2 ? x1 + (x2 - x1) * (y - y1) / (y2 - y1) : x1;
+        } else {
+            xa = y2 != y3 ? x2 + (x3 - x2) * (y - y2) / (y3 - y2) : x2;
+        }
+        
+        xb = y1 != y3 ? x1 + (x3 - x1) * (y - y1) / (y3 - y1) : x1;
+        
+        if (xa > xb) { i32 tmp = xa; xa = xb; xb = tmp; }
+        
+        draw_span(ctx, &clip, y, xa, xb + 1, packed, span);
+    }
+}
+
+/* Fixed-point triangle rasterizer
+ * Vertices are snapped to 28.4 fixed point and coverage is decided by edge
+ * functions evaluated at pixel centers with a top-left fill rule, so meshes
+ * sharing edges never draw a pixel twice. The bounding box is walked in
+ * 8x8 blocks that are trivially rejected or accepted from their corners.
+ */
+#define RASTER_SUBPIXEL_BITS 4
+#define RASTER_SUBPIXEL_ONE (1 << RASTER_SUBPIXEL_BITS)
+#define RASTER_BLOCK_SIZE 8
+#define RASTER_COORD_LIMIT (1 << 20)
+
+/* Edge function for edge a->b, stepped per pixel */
+typedef struct {
+    i64 step_x;   /* Change per pixel to the right */
+    i64 step_y;   /* Change per pixel down */
+    i64 origin;   /* Value at the center of pixel (0, 0), including the fill-rule bias */
+} raster_edge_t;
+
+/* Color channel plane in 16.16 fixed point */
+typedef struct {
+    i64 step_x, step_y, origin;
+} raster_plane_t;
+
+/* Helper: Snap a coordinate to 28.4 fixed point */
+static inline i32 raster_snap(f32 v) {
+    if (v > RASTER_COORD_LIMIT) v = RASTER_COORD_LIMIT;
+    if (v < -RASTER_COORD_LIMIT) v = -RASTER_COORD_LIMIT;
+    return (i32)lrintf(v * RASTER_SUBPIXEL_ONE);
+}
+
+/* Helper: Set up edge a->b so that pixels inside the triangle give values >= 0 */
+static void raster_edge_setup(raster_edge_t* e, i32 ax, i32 ay, i32 bx, i32 by) {
+    i64 dx = (i64)bx - ax;
+    i64 dy = (i64)by - ay;
+    
+    /* Top edge: horizontal and pointing right. Left edge: pointing up. */
+    bool top_left = (dy == 0 && dx > 0) || dy < 0;
+    
+    i64 px = RASTER_SUBPIXEL_ONE / 2;
+    i64 py = RASTER_SUBPIXEL_ONE / 2;
+    e->origin = dx * (py - ay) - dy * (px - ax) + (top_left ? 0 : -1);
+    e->step_x = -dy * RASTER_SUBPIXEL_ONE;
+    e->step_y = dx * RASTER_SUBPIXEL_ONE;
+}
+
+static inline i64 raster_edge_at(const raster_edge_t* e, i32 x, i32 y) {
+    return e->origin + e->step_x * x + e->step_y * y;
+}
+
+/* Helper: Plane through three channel values, evaluated at pixel centers */
+static void raster_plane_setup(raster_plane_t* p, const i32* fx, const i32* fy, f64 area, u8 c0, u8 c1, u8 c2) {
+    f64 d1 = (f64)c1 - c0;
+    f64 d2 = (f64)c2 - c0;
+    f64 dcdx = (d1 * (fy[2] - fy[0]) - d2 * (fy[1] - fy[0])) / area;
+    f64 dcdy = (d2 * (fx[1] - fx[0]) - d1 * (fx[2] - fx[0])) / area;
+    
+    /* Value at the center of pixel (0, 0), in 16.16 */
+    f64 cx = RASTER_SUBPIXEL_ONE / 2 - fx[0];
+    f64 cy = RASTER_SUBPIXEL_ONE / 2 - fy[0];
+    f64 origin = c0 + dcdx * cx + dcdy * cy;
+    
+    p->origin = (i64)llrint(origin * 65536.0);
+    p->step_x = (i64)llrint(dcdx * RASTER_SUBPIXEL_ONE * 65536.0);
+    p->step_y = (i64)llrint(dcdy * RASTER_SUBPIXEL_ONE * 65536.0);
+}
+
+static inline u32 raster_channel(i64 v) {
+    if (v < 0) return 0;
+    v >>= 16;
+    return v > 255 ? 255 : (u32)v;
+}
+
+/* Helper: Write a Gouraud-shaded span starting at pixel (x, y) */
+static void raster_shade_span(u32* dst, i32 x, i32 y, i32 count, const raster_plane_t* planes, bool blend, bool premultiplied) {
+    i64 r = planes[0].origin + planes[0].step_x * x + planes[0].step_y * y;
+    i64 g = planes[1].origin + planes[1].step_x * x + planes[1].step_y * y;
+    i64 b = planes[2].origin + planes[2].step_x * x + planes[2].step_y * y;
+    i64 a = planes[3].origin + planes[3].step_x * x + planes[3].step_y * y;
+    
+    for (i32 i = 0; i < count; i++) {
+        u32 packed = (raster_channel(a) << 24) | (raster_channel(b) << 16) |
+                     (raster_channel(g) << 8) | raster_channel(r);
+        if (premultiplied) {
+            packed = premultiply(packed);
+            dst[i] = blend ? blend_premultiplied(packed, dst[i]) : packed;
+        } else {
+            dst[i] = blend ? blend_colors(packed, dst[i]) : packed;
+        }
+        
+        r += planes[0].step_x;
+        g += planes[1].step_x;
+        b += planes[2].step_x;
+        a += planes[3].step_x;
+    }
+}
+
+/* Helper: Emit the covered run of row y within [x1, x2) */
+static void raster_emit(const graphics_context_t* ctx, i32 y, i32 x1, i32 x2,
+                        u32 packed, span_fn_t span, const raster_plane_t* planes, bool blend) {
+    if (x1 >= x2) return;
+    u32* dst = ctx_row(ctx, y) + x1;
+    if (planes && ctx->format == GRAPHICS_FORMAT_BGRA) {
+        /* Channels are interchangeable to the shader, so shade with red and blue swapped */
+        raster_plane_t swapped[4] = { planes[2], planes[1], planes[0], planes[3] };
+        raster_shade_span(dst, x1, y, x2 - x1, swapped, blend, false);
+    } else if (planes) {
+        raster_shade_span(dst, x1, y, x2 - x1, planes, blend, ctx->format == GRAPHICS_FORMAT_PREMULTIPLIED);
+    } else {
+        span(dst, x2 - x1, packed);
+    }
+}
+
+static void raster_triangle(graphics_context_t* ctx, const clip_box_t* clip,
+                            const graphics_vertex_t* v0, const graphics_vertex_t* v1, const graphics_vertex_t* v2,
+                            u32 flags) {
+    i32 fx[3] = { raster_snap(v0->x), raster_snap(v1->x), raster_snap(v2->x) };
+    i32 fy[3] = { raster_snap(v0->y), raster_snap(v1->y), raster_snap(v2->y) };
+    const graphics_vertex_t* verts[3] = { v0, v1, v2 };
+    
+    i64 area = ((i64)fx[1] - fx[0]) * ((i64)fy[2] - fy[0]) - ((i64)fy[1] - fy[0]) * ((i64)fx[2] - fx[0]);
+    if (area == 0) return;
+    
+    /* Make the winding consistent so inside is always positive */
+    if (area < 0) {
+        i32 t = fx[1]; fx[1] = fx[2]; fx[2] = t;
+        t = fy[1]; fy[1] = fy[2]; fy[2] = t;
+        const graphics_vertex_t* tv = verts[1]; verts[1] = verts[2]; verts[2] = tv;
+        area = -area;
+    }
+    
+    /* Pixel bounding box, clipped */
+    i32 min_x = ENGINE_MIN(fx[0], ENGINE_MIN(fx[1], fx[2])) >> RASTER_SUBPIXEL_BITS;
+    i32 min_y = ENGINE_MIN(fy[0], ENGINE_MIN(fy[1], fy[2])) >> RASTER_SUBPIXEL_BITS;
+    i32 max_x = (ENGINE_MAX(fx[0], ENGINE_MAX(fx[1], fx[2])) + RASTER_SUBPIXEL_ONE - 1) >> RASTER_SUBPIXEL_BITS;
+    i32 max_y = (ENGINE_MAX(fy[0], ENGINE_MAX(fy[1], fy[2])) + RASTER_SUBPIXEL_ONE - 1) >> RASTER_SUBPIXEL_BITS;
+    min_x = ENGINE_MAX(min_x, clip->x1);
+    min_y = ENGINE_MAX(min_y, clip->y1);
+    max_x = ENGINE_MIN(max_x, clip->x2);
+    max_y = ENGINE_MIN(max_y, clip->y2);
+    if (min_x >= max_x || min_y >= max_y) return;
+    damage_add_box(ctx, min_x, min_y, max_x, max_y);
+    
+    raster_edge_t edges[3];
+    raster_edge_setup(&edges[0], fx[1], fy[1], fx[2], fy[2]);
+    raster_edge_setup(&edges[1], fx[2], fy[2], fx[0], fy[0]);
+    raster_edge_setup(&edges[2], fx[0], fy[0], fx[1], fy[1]);
+    
+    /* Flat color or per-vertex planes */
+    u32 packed = 0;
+    span_fn_t span = NULL;
+    raster_plane_t planes[4];
+    const raster_plane_t* shade = NULL;
+    bool blend = false;
+    
+    if (flags & GRAPHICS_TRIANGLE_GOURAUD) {
+        const graphics_color_t* c[3] = { &verts[0]->color, &verts[1]->color, &verts[2]->color };
+        raster_plane_setup(&planes[0], fx, fy, (f64)area, c[0]->r, c[1]->r, c[2]->r);
+        raster_plane_setup(&planes[1], fx, fy, (f64)area, c[0]->g, c[1]->g, c[2]->g);
+        raster_plane_setup(&planes[2], fx, fy, (f64)area, c[0]->b, c[1]->b, c[2]->b);
+        raster_plane_setup(&planes[3], fx, fy, (f64)area, c[0]->a, c[1]->a, c[2]->a);
+        shade = planes;
+        blend = c[0]->a != 255 || c[1]->a != 255 || c[2]->a != 255;
+    } else {
+        span = select_span_fn(ctx, v0->color);
+        if (!span) return;
+        packed = ctx_pack(ctx, v0->color);
+    }
+    
+    /* Walk 8x8 blocks aligned to the pixel grid */
+    i32 block_x0 = min_x & ~(RASTER_BLOCK_SIZE - 1);
+    i32 block_y0 = min_y & ~(RASTER_BLOCK_SIZE - 1);
+    
+    for (i32 by = block_y0; by < max_y; by += RASTER_BLOCK_SIZE) {
+        i32 y1 = ENGINE_MAX(by, min_y);
+        i32 y2 = ENGINE_MIN(by + RASTER_BLOCK_SIZE, max_y);
+        
+        for (i32 bx = block_x0; bx < max_x; bx += RASTER_BLOCK_SIZE) {
+            i32 x1 = ENGINE_MAX(bx, min_x);
+            i32 x2 = ENGINE_MIN(bx + RASTER_BLOCK_SIZE, max_x);
+            
+            /* Classify the block from the edge values at its corner pixels */
+            bool reject = false;
+            bool accept = true;
+            for (i32 e = 0; e < 3; e++) {
+                i64 c00 = raster_edge_at(&edges[e], x1, y1);
+                i64 c10 = raster_edge_at(&edges[e], x2 - 1, y1);
+                i64 c01 = raster_edge_at(&edges[e], x1, y2 - 1);
+                i64 c11 = raster_edge_at(&edges[e], x2 - 1, y2 - 1);
+                
+                if (c00 < 0 && c10 < 0 && c01 < 0 && c11 < 0) {
+                    reject = true;
+                    break;
+                }
+                if (c00 < 0 || c10 < 0 || c01 < 0 || c11 < 0) {
+                    accept = false;
+                }
+            }
+            if (reject) continue;
+            
+            if (accept) {
+                for (i32 y = y1; y < y2; y++) {
+                    raster_emit(ctx, y, x1, x2, packed, span, shade, blend);
+                }
+                continue;
+            }
+            
+            /* Partial block: rows of a convex shape are a single run */
+            for (i32 y = y1; y < y2; y++) {
+                i64 w0 = raster_edge_at(&edges[0], x1, y);
+                i64 w1 = raster_edge_at(&edges[1], x1, y);
+                i64 w2 = raster_edge_at(&edges[2], x1, y);
+                i32 run_start = -1;
+                i32 run_end = -1;
+                
+                for (i32 x = x1; x < x2; x++) {
+                    if ((w0 | w1 | w2) >= 0) {
+                        if (run_start < 0) run_start = x;
+                        run_end = x + 1;
+                    } else if (run_start >= 0) {
+                        break;
+                    }
+                    w0 += edges[0].step_x;
+                    w1 += edges[1].step_x;
+                    w2 += edges[2].step_x;
+                }
+                
+                if (run_start >= 0) {
+                    raster_emit(ctx, y, run_start, run_end, packed, span, shade, blend);
+                }
+            }
+        }
+    }
+}
+
+/* Helper: Record a sub-pixel triangle with pixel bounds covering its vertices */
+static void defer_triangle(graphics_context_t* ctx, const graphics_vertex_t* v1, const graphics_vertex_t* v2, const graphics_vertex_t* v3, u32 flags) {
+    i32 fx[3] = { raster_snap(v1->x), raster_snap(v2->x), raster_snap(v3->x) };
+    i32 fy[3] = { raster_snap(v1->y), raster_snap(v2->y), raster_snap(v3->y) };
+    i32 x1 = ENGINE_MIN(fx[0], ENGINE_MIN(fx[1], fx[2])) >> RASTER_SUBPIXEL_BITS;
+    i32 y1 = ENGINE_MIN(fy[0], ENGINE_MIN(fy[1], fy[2])) >> RASTER_SUBPIXEL_BITS;
+    i32 x2 = (ENGINE_MAX(fx[0], ENGINE_MAX(fx[1], fx[2])) >> RASTER_SUBPIXEL_BITS) + 1;
+    i32 y2 = (ENGINE_MAX(fy[0], ENGINE_MAX(fy[1], fy[2])) >> RASTER_SUBPIXEL_BITS) + 1;
+    
+    graphics_cmd_t* cmd = defer_cmd(ctx, GRAPHICS_CMD_FILL_TRIANGLE_EX, x1, y1, x2, y2, v1->color);
+    if (cmd) {
+        cmd->data.triangle.v[0] = *v1;
+        cmd->data.triangle.v[1] = *v2;
+        cmd->data.triangle.v[2] = *v3;
+        cmd->data.triangle.flags = flags;
+    }
+}
+
+void graphics_fill_triangle_ex(graphics_context_t* ctx, const graphics_vertex_t* v1, const graphics_vertex_t* v2, const graphics_vertex_t* v3, u32 flags) {
+    if (!ctx || !v1 || !v2 || !v3) return;
+    
+    if (ctx->record) {
+        defer_triangle(ctx, v1, v2, v3, flags);
+        return;
+    }
+    
+    clip_box_t clip;
+    if (!get_clip_box(ctx, &clip)) return;
+    
+    raster_triangle(ctx, &clip, v1, v2, v3, flags);
+}
+
+void graphics_fill_triangles(graphics_context_t* ctx, const graphics_vertex_t* vertices, i32 vertex_count, u32 flags) {
+    if (!ctx || !vertices) return;
+    
+    if (ctx->record) {
+        for (i32 i = 0; i + 2 < vertex_count; i += 3) {
+            defer_triangle(ctx, &vertices[i], &vertices[i + 1], &vertices[i + 2], flags);
+        }
+        return;
+    }
+    
+    clip_box_t clip;
+    if (!get_clip_box(ctx, &clip)) return;
+    
+    for (i32 i = 0; i + 2 < vertex_count; i += 3) {
+        raster_triangle(ctx, &clip, &vertices[i], &vertices[i + 1], &vertices[i + 2], flags);
+    }
+}
+
+/* Glyph cache
+ * Each font's glyph bitmaps are expanded once into horizontal runs of set
+ * pixels. Coverage is one bit, so the runs do not depend on the text color;
+ * the color is packed once per draw call. Built lazily and shared by the
+ * render workers, so lookups are lock-free and building takes a lock. */
+#define GLYPH_CACHE_FONTS 8
+#define GLYPH_COUNT 95  /* ASCII 32-126 */
+
+typedef struct {
+    u8 row;
+    u8 x;
+    u8 length;
+} glyph_span_t;
+
+typedef struct {
+    const graphics_font_t* font;
+    glyph_span_t* spans;
+    u32 first[GLYPH_COUNT + 1];  /* Glyph g owns spans[first[g], first[g + 1]) */
+} glyph_cache_entry_t;
+
+static glyph_cache_entry_t g_glyph_cache[GLYPH_CACHE_FONTS];
+static i32 g_glyph_cache_count = 0;
+static pthread_mutex_t g_glyph_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Helper: Is pixel (col, row) of a glyph set */
+static inline bool glyph_bit(const graphics_font_t* font, i32 glyph_index, i32 row, i32 col) {
+    const u8* bits = font->glyphs + ((size_t)glyph_index * font->glyph_height + row) * font->bytes_per_row;
+    /* Read bits from right to left (LSB to MSB) */
+    return (bits[col >> 3] >> (col & 7)) & 1;
+}
+
+/* Helper: Expand every glyph of a font into runs */
+static bool glyph_cache_build(glyph_cache_entry_t* entry, const graphics_font_t* font) {
+    u32 count = 0;
+    for (i32 pass = 0; pass < 2; pass++) {
+        count = 0;
+        for (i32 g = 0; g < GLYPH_COUNT; g++) {
+            if (pass) entry->first[g] = count;
+            for (i32 row = 0; row < font->glyph_height; row++) {
+                for (i32 col = 0; col < font->glyph_width; col++) {
+                    if (!glyph_bit(font, g, row, col)) continue;
+                    
+                    i32 start = col;
+                    while (col + 1 < font->glyph_width && glyph_bit(font, g, row, col + 1)) col++;
+                    if (pass) {
+                        entry->spans[count].row = (u8)row;
+                        entry->spans[count].x = (u8)start;
+                        entry->spans[count].length = (u8)(col - start + 1);
+                    }
+                    count++;
+                }
+            }
+        }
+        
+        /* First pass counts, second fills */
+        if (!pass) {
+            entry->spans = (glyph_span_t*)malloc((size_t)ENGINE_MAX(count, 1) * sizeof(glyph_span_t));
+            if (!entry->spans) {
+                ENGINE_LOG_ERROR("Failed to allocate glyph cache");
+                return false;
+            }
+        }
+    }
+    entry->first[GLYPH_COUNT] = count;
+    return true;
+}
+
+/* Helper: Cached runs for a font, or NULL if it cannot be cached */
+static const glyph_cache_entry_t* glyph_cache_get(const graphics_font_t* font) {
+    if (font->glyph_width > 255 || font->glyph_height > 255) return NULL;
+    
+    i32 count = __atomic_load_n(&g_glyph_cache_count, __ATOMIC_ACQUIRE);
+    for (i32 i = 0; i < count; i++) {
+        if (g_glyph_cache[i].font == font) return &g_glyph_cache[i];
+    }
+    
+    pthread_mutex_lock(&g_glyph_cache_lock);
+    const glyph_cache_entry_t* found = NULL;
+    for (i32 i = 0; i < g_glyph_cache_count && !found; i++) {
+        if (g_glyph_cache[i].font == font) found = &g_glyph_cache[i];
+    }
+    if (!found && g_glyph_cache_count < GLYPH_CACHE_FONTS) {
+        glyph_cache_entry_t* entry = &g_glyph_cache[g_glyph_cache_count];
+        if (glyph_cache_build(entry, font)) {
+            entry->font = font;
+            __atomic_store_n(&g_glyph_cache_count, g_glyph_cache_count + 1, __ATOMIC_RELEASE);
+            found = entry;
+        }
+    }
+    pthread_mutex_unlock(&g_glyph_cache_lock);
+    return found;
+}
+
+/* Text rendering */
+graphics_font_t* graphics_get_default_font(void) {
+    return &g_default_font;
+}
+
+void graphics_draw_text(graphics_context_t* ctx, const char* text, i32 x, i32 y, graphics_color_t color, graphics_font_t* font) {
+    if (!ctx || !text) return;
+    if (!font) font = &g_default_font;
+    
+    if (ctx->record) {
+        i32 width, height;
+        graphics_measure_text(text, font, &width, &height);
+        graphics_cmd_t* cmd = defer_cmd(ctx, GRAPHICS_CMD_TEXT, x, y, x + width, y + height, color);
+        if (cmd) {
+            i64 offset = cmd_list_push_text(ctx->record, text);
+            if (offset < 0) {
+                ctx->record->count--;
+                return;
+            }
+            cmd->data.text.x = x;
+            cmd->data.text.y = y;
+            cmd->data.text.offset = (u32)offset;
+            cmd->data.text.font = font;
+        }
+        return;
+    }
+    
+    if (ctx->damage_tracking) {
+        i32 width, height;
+        graphics_measure_text(text, font, &width, &height);
+        mark_damage(ctx, x, y, x + width, y + height);
+    }
+    
+    clip_box_t clip;
+    span_fn_t span = select_span_fn(ctx, color);
+    if (!span || !get_clip_box(ctx, &clip)) return;
+    
+    const glyph_cache_entry_t* cache = glyph_cache_get(font);
+    u32 packed = ctx_pack(ctx, color);
+    bool opaque = color.a == 255;
+    i32 start_x = x;
     
     for (const char* p = text; *p; p++) {
         i32 ch = (i32)(*p);
@@ -631,63 +2257,776 @@ void graphics_draw_text(graphics_context_t* ctx, const char* text, i32 x, i32 y,
         if (ch < 32 || ch > 126) {
             ch = '?';
         }
-        
-        /* Get glyph data */
-        i32 glyph_index = ch - 32;
-        const u8* glyph = font->glyphs + (glyph_index * font->glyph_height);
-        
-        /* Draw glyph */
-        for (i32 row = 0; row < font->glyph_height; row++) {
-            u8 byte = glyph[row];
-            for (i32 col = 0; col < font->glyph_width; col++) {
-                /* Read bits from right to left (LSB to MSB) */
-                if (byte & (1 << col)) {
-                    graphics_draw_pixel(ctx, x + col, y + row, color);
-                }
+        
+        i32 glyph_x = x;
+        x += font->glyph_width;
+        
+        /* Clip once per glyph; lines above or below the clip are skipped whole */
+        if (y >= clip.y2) break;
+        if (y + font->glyph_height <= clip.y1 || glyph_x >= clip.x2 || x <= clip.x1) continue;
+        bool inside = glyph_x >= clip.x1 && x <= clip.x2 && y >= clip.y1 && y + font->glyph_height <= clip.y2;
+        i32 glyph_index = ch - 32;
+        
+        if (!cache) {
+            for (i32 row = 0; row < font->glyph_height; row++) {
+                for (i32 col = 0; col < font->glyph_width; col++) {
+                    if (glyph_bit(font, glyph_index, row, col)) {
+                        draw_span(ctx, &clip, y + row, glyph_x + col, glyph_x + col + 1, packed, span);
+                    }
+                }
+            }
+            continue;
+        }
+        
+        const glyph_span_t* run = cache->spans + cache->first[glyph_index];
+        const glyph_span_t* end = cache->spans + cache->first[glyph_index + 1];
+        
+        if (inside && opaque) {
+            /* Runs are a few pixels long, plain stores beat a kernel call */
+            for (; run < end; run++) {
+                u32* dst = ctx_row(ctx, y + run->row) + glyph_x + run->x;
+                for (i32 i = 0; i < run->length; i++) dst[i] = packed;
+            }
+        } else if (inside) {
+            for (; run < end; run++) {
+                span(ctx_row(ctx, y + run->row) + glyph_x + run->x, run->length, packed);
+            }
+        } else {
+            for (; run < end; run++) {
+                i32 run_x = glyph_x + run->x;
+                draw_span(ctx, &clip, y + run->row, run_x, run_x + run->length, packed, span);
+            }
+        }
+    }
+}
+
+void graphics_measure_text(const char* text, graphics_font_t* font, i32* out_width, i32* out_height) {
+    if (!text) {
+        if (out_width) *out_width = 0;
+        if (out_height) *out_height = 0;
+        return;
+    }
+    
+    if (!font) font = &g_default_font;
+    
+    i32 width = 0;
+    i32 height = font->glyph_height;
+    i32 line_width = 0;
+    
+    for (const char* p = text; *p; p++) {
+        if (*p == '\n') {
+            height += font->glyph_height;
+            if (line_width > width) width = line_width;
+            line_width = 0;
+        } else {
+            line_width += font->glyph_width;
+        }
+    }
+    
+    if (line_width > width) width = line_width;
+    
+    if (out_width) *out_width = width;
+    if (out_height) *out_height = height;
+}
+
+/* Worker pool
+ * Runs a batch of independent tasks on GRAPHICS_MAX_THREADS-bounded worker
+ * threads, with the calling thread taking tasks too. One batch runs at a
+ * time; a caller that finds the pool busy runs its batch inline. While the
+ * engine's job system has workers, batches go to it instead and these
+ * threads are never started.
+ */
+typedef void (*graphics_task_fn_t)(void* user, i32 index);
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    pthread_mutex_t run_lock;
+    pthread_t threads[GRAPHICS_MAX_THREADS];
+    i32 thread_count;
+    i32 requested_threads;   /* 0 = one per extra CPU */
+    bool started;
+    bool shutdown;
+    bool atexit_registered;
+    
+    /* Current batch */
+    graphics_task_fn_t fn;
+    void* user;
+    i32 task_count;
+    i32 next_task;
+    i32 busy_workers;
+    u32 generation;
+} g_pool = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    PTHREAD_MUTEX_INITIALIZER, {0}, 0, 0, false, false, false, NULL, NULL, 0, 0, 0, 0
+};
+
+/* Helper: Take tasks from the current batch until none are left */
+static void pool_drain(void) {
+    for (;;) {
+        i32 index = __atomic_fetch_add(&g_pool.next_task, 1, __ATOMIC_RELAXED);
+        if (index >= g_pool.task_count) break;
+        g_pool.fn(g_pool.user, index);
+    }
+}
+
+static void* pool_worker(void* arg) {
+    (void)arg;
+    u32 seen = 0;
+    ENGINE_PROFILE_THREAD("graphics worker");
+    
+    pthread_mutex_lock(&g_pool.lock);
+    for (;;) {
+        while (!g_pool.shutdown && g_pool.generation == seen) {
+            pthread_cond_wait(&g_pool.wake, &g_pool.lock);
+        }
+        if (g_pool.shutdown) break;
+        seen = g_pool.generation;
+        pthread_mutex_unlock(&g_pool.lock);
+        
+        pool_drain();
+        
+        pthread_mutex_lock(&g_pool.lock);
+        if (--g_pool.busy_workers == 0) {
+            pthread_cond_signal(&g_pool.done);
+        }
+    }
+    pthread_mutex_unlock(&g_pool.lock);
+    return NULL;
+}
+
+/* Helper: Stop and join all workers. Caller must hold run_lock. */
+static void pool_stop(void) {
+    if (!g_pool.started) return;
+    
+    pthread_mutex_lock(&g_pool.lock);
+    g_pool.shutdown = true;
+    pthread_cond_broadcast(&g_pool.wake);
+    pthread_mutex_unlock(&g_pool.lock);
+    
+    for (i32 i = 0; i < g_pool.thread_count; i++) {
+        pthread_join(g_pool.threads[i], NULL);
+    }
+    
+    g_pool.thread_count = 0;
+    g_pool.started = false;
+    g_pool.shutdown = false;
+}
+
+static void pool_shutdown_at_exit(void) {
+    pthread_mutex_lock(&g_pool.run_lock);
+    pool_stop();
+    pthread_mutex_unlock(&g_pool.run_lock);
+}
+
+/* Helper: Start the workers on first use. Caller must hold run_lock. */
+static void pool_start(void) {
+    if (g_pool.started) return;
+    g_pool.started = true;
+    
+    i32 count = g_pool.requested_threads;
+    if (count <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        count = cpus > 1 ? (i32)cpus - 1 : 0;
+    }
+    if (count > GRAPHICS_MAX_THREADS) count = GRAPHICS_MAX_THREADS;
+    
+    g_pool.thread_count = 0;
+    for (i32 i = 0; i < count; i++) {
+        if (pthread_create(&g_pool.threads[i], NULL, pool_worker, NULL) != 0) {
+            ENGINE_LOG_WARN("Failed to start graphics worker %d", i);
+            break;
+        }
+        g_pool.thread_count++;
+    }
+    
+    if (!g_pool.atexit_registered) {
+        atexit(pool_shutdown_at_exit);
+        g_pool.atexit_registered = true;
+    }
+    ENGINE_LOG_INFO("Graphics worker pool started: %d threads", g_pool.thread_count);
+}
+
+/* A batch handed to the engine's job system */
+typedef struct {
+    graphics_task_fn_t fn;
+    void* user;
+} pool_batch_t;
+
+static void pool_run_range(void* user, i32 begin, i32 end) {
+    const pool_batch_t* batch = (const pool_batch_t*)user;
+    for (i32 i = begin; i < end; i++) batch->fn(batch->user, i);
+}
+
+/* Helper: Run fn(user, 0..count-1) across the pool and wait for all of them */
+static void pool_run(graphics_task_fn_t fn, void* user, i32 count) {
+    if (count <= 0) return;
+    
+    /* Share the job system's workers when it has any, one task per job */
+    if (jobs_get_worker_count() > 0) {
+        pool_batch_t batch = { fn, user };
+        jobs_parallel_for(count, 1, pool_run_range, &batch);
+        return;
+    }
+    
+    if (count == 1 || pthread_mutex_trylock(&g_pool.run_lock) != 0) {
+        for (i32 i = 0; i < count; i++) fn(user, i);
+        return;
+    }
+    
+    pool_start();
+    if (g_pool.thread_count == 0) {
+        for (i32 i = 0; i < count; i++) fn(user, i);
+        pthread_mutex_unlock(&g_pool.run_lock);
+        return;
+    }
+    
+    pthread_mutex_lock(&g_pool.lock);
+    g_pool.fn = fn;
+    g_pool.user = user;
+    g_pool.task_count = count;
+    g_pool.next_task = 0;
+    g_pool.busy_workers = g_pool.thread_count;
+    g_pool.generation++;
+    pthread_cond_broadcast(&g_pool.wake);
+    pthread_mutex_unlock(&g_pool.lock);
+    
+    pool_drain();
+    
+    pthread_mutex_lock(&g_pool.lock);
+    while (g_pool.busy_workers > 0) {
+        pthread_cond_wait(&g_pool.done, &g_pool.lock);
+    }
+    pthread_mutex_unlock(&g_pool.lock);
+    
+    pthread_mutex_unlock(&g_pool.run_lock);
+}
+
+void graphics_set_render_threads(i32 count) {
+    pthread_mutex_lock(&g_pool.run_lock);
+    pool_stop();
+    g_pool.requested_threads = count < 0 ? 0 : count;
+    pthread_mutex_unlock(&g_pool.run_lock);
+}
+
+/* Helper: Execute one recorded command against ctx */
+static void execute_cmd(graphics_context_t* ctx, const graphics_cmd_t* cmd, const char* text) {
+    switch (cmd->type) {
+        case GRAPHICS_CMD_CLEAR: {
+            /* Clears ignore the clip rect, so only the tile itself bounds them */
+            clip_box_t clip;
+            if (!get_clip_box(ctx, &clip)) break;
+            u32 packed = ctx_pack(ctx, cmd->color);
+            for (i32 y = clip.y1; y < clip.y2; y++) {
+                ctx->spans->fill(ctx_row(ctx, y) + clip.x1, clip.x2 - clip.x1, packed);
+            }
+            break;
+        }
+        case GRAPHICS_CMD_PIXEL:
+            graphics_draw_pixel(ctx, cmd->data.points.x1, cmd->data.points.y1, cmd->color);
+            break;
+        case GRAPHICS_CMD_LINE:
+            graphics_draw_line(ctx, cmd->data.points.x1, cmd->data.points.y1,
+                               cmd->data.points.x2, cmd->data.points.y2, cmd->color);
+            break;
+        case GRAPHICS_CMD_RECT:
+            graphics_draw_rect(ctx, &cmd->data.rect, cmd->color);
+            break;
+        case GRAPHICS_CMD_FILL_RECT:
+            graphics_fill_rect(ctx, &cmd->data.rect, cmd->color);
+            break;
+        case GRAPHICS_CMD_CIRCLE:
+            graphics_draw_circle(ctx, cmd->data.circle.cx, cmd->data.circle.cy, cmd->data.circle.radius, cmd->color);
+            break;
+        case GRAPHICS_CMD_FILL_CIRCLE:
+            graphics_fill_circle(ctx, cmd->data.circle.cx, cmd->data.circle.cy, cmd->data.circle.radius, cmd->color);
+            break;
+        case GRAPHICS_CMD_FILL_TRIANGLE:
+            graphics_fill_triangle(ctx, cmd->data.points.x1, cmd->data.points.y1, cmd->data.points.x2,
+                                   cmd->data.points.y2, cmd->data.points.x3, cmd->data.points.y3, cmd->color);
+            break;
+        case GRAPHICS_CMD_FILL_TRIANGLE_EX:
+            graphics_fill_triangle_ex(ctx, &cmd->data.triangle.v[0], &cmd->data.triangle.v[1],
+                                      &cmd->data.triangle.v[2], cmd->data.triangle.flags);
+            break;
+        case GRAPHICS_CMD_TEXT:
+            graphics_draw_text(ctx, text + cmd->data.text.offset, cmd->data.text.x, cmd->data.text.y,
+                               cmd->color, cmd->data.text.font);
+            break;
+        case GRAPHICS_CMD_IMAGE:
+            graphics_draw_image(ctx, cmd->data.image.image, cmd->data.image.dest.x, cmd->data.image.dest.y);
+            break;
+        case GRAPHICS_CMD_IMAGE_SCALED:
+            graphics_draw_image_scaled_ex(ctx, cmd->data.image.image, &cmd->data.image.dest,
+                                          (graphics_filter_t)cmd->data.image.filter);
+            break;
+        case GRAPHICS_CMD_LAYER:
+            graphics_draw_layer(ctx, cmd->data.layer.layer, cmd->data.layer.x, cmd->data.layer.y);
+            break;
+        case GRAPHICS_CMD_SPRITE:
+            graphics_draw_sprite(ctx, cmd->data.sprite.atlas, cmd->data.sprite.sprite,
+                                 cmd->data.sprite.x, cmd->data.sprite.y);
+            break;
+    }
+}
+
+/* Helper: Bin every command into the tiles its bounds touch, keeping submission order */
+static bool bin_commands(graphics_context_t* ctx) {
+    struct graphics_deferred* d = ctx->deferred;
+    const graphics_cmd_list_t* list = &d->list;
+    
+    d->tiles_x = (ctx->width + GRAPHICS_TILE_SIZE - 1) / GRAPHICS_TILE_SIZE;
+    d->tiles_y = (ctx->height + GRAPHICS_TILE_SIZE - 1) / GRAPHICS_TILE_SIZE;
+    i32 tile_count = d->tiles_x * d->tiles_y;
+    
+    if (tile_count + 1 > d->bin_capacity) {
+        i32* start = (i32*)realloc(d->bin_start, (size_t)(tile_count + 1) * sizeof(i32));
+        if (!start) return false;
+        d->bin_start = start;
+        d->bin_capacity = tile_count + 1;
+    }
+    memset(d->bin_start, 0, (size_t)(tile_count + 1) * sizeof(i32));
+    
+    /* Pass 1: count entries per tile */
+    i32 total = 0;
+    for (i32 i = 0; i < list->count; i++) {
+        const graphics_rect_t* b = &list->cmds[i].bounds;
+        i32 tx1 = b->x / GRAPHICS_TILE_SIZE;
+        i32 ty1 = b->y / GRAPHICS_TILE_SIZE;
+        i32 tx2 = (b->x + b->width - 1) / GRAPHICS_TILE_SIZE;
+        i32 ty2 = (b->y + b->height - 1) / GRAPHICS_TILE_SIZE;
+        for (i32 ty = ty1; ty <= ty2; ty++) {
+            for (i32 tx = tx1; tx <= tx2; tx++) {
+                d->bin_start[ty * d->tiles_x + tx + 1]++;
+            }
+        }
+        total += (tx2 - tx1 + 1) * (ty2 - ty1 + 1);
+    }
+    
+    if (total > d->bin_cmds_capacity) {
+        i32* cmds = (i32*)realloc(d->bin_cmds, (size_t)total * sizeof(i32));
+        if (!cmds) return false;
+        d->bin_cmds = cmds;
+        d->bin_cmds_capacity = total;
+    }
+    
+    /* Prefix sum, then pass 2: fill bins using bin_start[t + 1] as the write cursor */
+    for (i32 t = 1; t <= tile_count; t++) {
+        d->bin_start[t] += d->bin_start[t - 1];
+    }
+    for (i32 t = tile_count; t > 0; t--) {
+        d->bin_start[t] = d->bin_start[t - 1];
+    }
+    for (i32 i = 0; i < list->count; i++) {
+        const graphics_rect_t* b = &list->cmds[i].bounds;
+        i32 tx1 = b->x / GRAPHICS_TILE_SIZE;
+        i32 ty1 = b->y / GRAPHICS_TILE_SIZE;
+        i32 tx2 = (b->x + b->width - 1) / GRAPHICS_TILE_SIZE;
+        i32 ty2 = (b->y + b->height - 1) / GRAPHICS_TILE_SIZE;
+        for (i32 ty = ty1; ty <= ty2; ty++) {
+            for (i32 tx = tx1; tx <= tx2; tx++) {
+                d->bin_cmds[d->bin_start[ty * d->tiles_x + tx + 1]++] = i;
             }
         }
+    }
+    
+    return true;
+}
+
+/* Helper: Rasterize one tile's commands with the clip narrowed to the tile */
+static void render_tile(void* user, i32 tile) {
+    graphics_context_t* ctx = (graphics_context_t*)user;
+    const struct graphics_deferred* d = ctx->deferred;
+    ENGINE_PROFILE_BEGIN("render_tile");
+    
+    i32 tile_x = (tile % d->tiles_x) * GRAPHICS_TILE_SIZE;
+    i32 tile_y = (tile / d->tiles_x) * GRAPHICS_TILE_SIZE;
+    
+    /* Immediate-mode view of the same pixels */
+    graphics_context_t tile_ctx = *ctx;
+    tile_ctx.deferred = NULL;
+    tile_ctx.record = NULL;
+    tile_ctx.clipping_enabled = true;
+    tile_ctx.damage_tracking = false;
+    
+    for (i32 i = d->bin_start[tile]; i < d->bin_start[tile + 1]; i++) {
+        const graphics_cmd_t* cmd = &d->list.cmds[d->bin_cmds[i]];
         
-        x += font->glyph_width;
+        i32 x1 = ENGINE_MAX(cmd->clip.x, tile_x);
+        i32 y1 = ENGINE_MAX(cmd->clip.y, tile_y);
+        i32 x2 = ENGINE_MIN(cmd->clip.x + cmd->clip.width, tile_x + GRAPHICS_TILE_SIZE);
+        i32 y2 = ENGINE_MIN(cmd->clip.y + cmd->clip.height, tile_y + GRAPHICS_TILE_SIZE);
+        if (x1 >= x2 || y1 >= y2) continue;
+        
+        tile_ctx.clip_rect = graphics_rect(x1, y1, x2 - x1, y2 - y1);
+        execute_cmd(&tile_ctx, cmd, d->list.text);
     }
+    ENGINE_PROFILE_END();
 }
 
-void graphics_measure_text(const char* text, graphics_font_t* font, i32* out_width, i32* out_height) {
-    if (!text) {
-        if (out_width) *out_width = 0;
-        if (out_height) *out_height = 0;
+/* Deferred rendering control */
+void graphics_begin_deferred(graphics_context_t* ctx) {
+    if (!ctx || ctx->deferred) return;
+    
+    ctx->deferred = (struct graphics_deferred*)calloc(1, sizeof(struct graphics_deferred));
+    if (!ctx->deferred) {
+        ENGINE_LOG_ERROR("Failed to allocate deferred renderer, staying in immediate mode");
         return;
     }
     
-    if (!font) font = &g_default_font;
+    /* While a display list is being recorded, deferral starts once recording ends */
+    if (ctx->record) {
+        ctx->record_saved = &ctx->deferred->list;
+    } else {
+        ctx->record = &ctx->deferred->list;
+    }
+}
+
+void graphics_flush(graphics_context_t* ctx) {
+    if (!ctx || !ctx->deferred || ctx->deferred->list.count == 0) return;
     
-    i32 width = 0;
-    i32 height = font->glyph_height;
-    i32 line_width = 0;
+    struct graphics_deferred* d = ctx->deferred;
+    ENGINE_PROFILE_BEGIN("graphics_flush");
+    view_sync(ctx);
     
-    for (const char* p = text; *p; p++) {
-        if (*p == '\n') {
-            height += font->glyph_height;
-            if (line_width > width) width = line_width;
-            line_width = 0;
-        } else {
-            line_width += font->glyph_width;
+    if (bin_commands(ctx)) {
+        pool_run(render_tile, ctx, d->tiles_x * d->tiles_y);
+    } else {
+        /* Out of memory for bins: replay everything on this thread instead */
+        ENGINE_LOG_WARN("Failed to bin graphics commands, rendering serially");
+        graphics_context_t immediate = *ctx;
+        immediate.deferred = NULL;
+        immediate.record = NULL;
+        immediate.damage_tracking = false;
+        for (i32 i = 0; i < d->list.count; i++) {
+            const graphics_cmd_t* cmd = &d->list.cmds[i];
+            immediate.clip_rect = cmd->clip;
+            immediate.clipping_enabled = true;
+            execute_cmd(&immediate, cmd, d->list.text);
         }
     }
     
-    if (line_width > width) width = line_width;
+    d->list.count = 0;
+    d->list.text_size = 0;
+    ENGINE_PROFILE_END();
+}
+
+void graphics_end_deferred(graphics_context_t* ctx) {
+    if (!ctx || !ctx->deferred) return;
     
-    if (out_width) *out_width = width;
-    if (out_height) *out_height = height;
+    graphics_flush(ctx);
+    
+    struct graphics_deferred* d = ctx->deferred;
+    ctx->deferred = NULL;
+    if (ctx->record == &d->list) ctx->record = NULL;
+    /* A display list still recording now ends back in immediate mode */
+    if (ctx->record_saved == &d->list) ctx->record_saved = ctx->record;
+    cmd_list_free(&d->list);
+    free(d->bin_start);
+    free(d->bin_cmds);
+    free(d);
+}
+
+bool graphics_is_deferred(const graphics_context_t* ctx) {
+    return ctx && ctx->deferred;
+}
+
+/* Display lists
+ * A display list holds commands recorded from a context and can be replayed
+ * into any context. Finalizing reorders commands only past commands they do
+ * not overlap, then merges neighbours that draw the same way: touching
+ * same-color rects become one rect and text pieces that continue each other
+ * on one line become one glyph run.
+ */
+#define DISPLAY_LIST_MERGE_WINDOW 32
+
+struct graphics_display_list {
+    graphics_cmd_list_t list;
+    bool finalized;  /* Recording has ended; only finalized lists replay */
+};
+
+graphics_display_list_t* graphics_display_list_create(void) {
+    graphics_display_list_t* list = (graphics_display_list_t*)calloc(1, sizeof(graphics_display_list_t));
+    if (!list) {
+        ENGINE_LOG_ERROR("Failed to allocate display list");
+        return NULL;
+    }
+    return list;
+}
+
+void graphics_display_list_destroy(graphics_display_list_t* list) {
+    if (!list) return;
+    cmd_list_free(&list->list);
+    free(list);
+}
+
+void graphics_display_list_reset(graphics_display_list_t* list) {
+    if (!list) return;
+    list->list.count = 0;
+    list->list.text_size = 0;
+    list->finalized = false;
+}
+
+i32 graphics_display_list_get_count(const graphics_display_list_t* list) {
+    return list ? list->list.count : 0;
+}
+
+void graphics_begin_record(graphics_context_t* ctx, graphics_display_list_t* list) {
+    if (!ctx || !list || ctx->record_saved) return;
+    
+    graphics_display_list_reset(list);
+    
+    /* NULL record_saved would be ambiguous, so remember immediate mode as the list itself */
+    ctx->record_saved = ctx->record ? ctx->record : &list->list;
+    ctx->record = &list->list;
+}
+
+/* Helper: Two clip boxes are the same */
+static inline bool rect_equal(const graphics_rect_t* a, const graphics_rect_t* b) {
+    return a->x == b->x && a->y == b->y && a->width == b->width && a->height == b->height;
+}
+
+/* Helper: Rect bounds overlap */
+static inline bool bounds_overlap(const graphics_rect_t* a, const graphics_rect_t* b) {
+    return a->x < b->x + b->width && b->x < a->x + a->width &&
+           a->y < b->y + b->height && b->y < a->y + a->height;
+}
+
+/* Helper: Union of two rects that tile a larger rect exactly, without overlap */
+static bool rect_join(const graphics_rect_t* a, const graphics_rect_t* b, graphics_rect_t* out) {
+    if (a->x == b->x && a->width == b->width) {
+        if (a->y + a->height == b->y) { *out = graphics_rect(a->x, a->y, a->width, a->height + b->height); return true; }
+        if (b->y + b->height == a->y) { *out = graphics_rect(a->x, b->y, a->width, a->height + b->height); return true; }
+    }
+    if (a->y == b->y && a->height == b->height) {
+        if (a->x + a->width == b->x) { *out = graphics_rect(a->x, a->y, a->width + b->width, a->height); return true; }
+        if (b->x + b->width == a->x) { *out = graphics_rect(b->x, a->y, a->width + b->width, a->height); return true; }
+    }
+    return false;
+}
+
+/* Helper: Try to fold cmd into an earlier command `into` of the output list */
+static bool display_list_merge(graphics_cmd_list_t* out, graphics_cmd_t* into, const graphics_cmd_t* cmd, const char* cmd_text) {
+    if (into->type != cmd->type || !rect_equal(&into->clip, &cmd->clip) ||
+        memcmp(&into->color, &cmd->color, sizeof(graphics_color_t)) != 0) {
+        return false;
+    }
+    
+    if (cmd->type == GRAPHICS_CMD_FILL_RECT) {
+        graphics_rect_t joined;
+        if (cmd->data.rect.width <= 0 || cmd->data.rect.height <= 0) return false;
+        if (!rect_join(&into->data.rect, &cmd->data.rect, &joined)) return false;
+        
+        into->data.rect = joined;
+        i32 x1 = ENGINE_MAX(joined.x, into->clip.x);
+        i32 y1 = ENGINE_MAX(joined.y, into->clip.y);
+        i32 x2 = ENGINE_MIN(joined.x + joined.width, into->clip.x + into->clip.width);
+        i32 y2 = ENGINE_MIN(joined.y + joined.height, into->clip.y + into->clip.height);
+        into->bounds = graphics_rect(x1, y1, x2 - x1, y2 - y1);
+        return true;
+    }
+    
+    if (cmd->type == GRAPHICS_CMD_TEXT) {
+        const char* first = out->text + into->data.text.offset;
+        size_t first_len = strlen(first);
+        size_t second_len = strlen(cmd_text);
+        
+        /* The second run must start exactly where the first one ends, on the same line */
+        if (into->data.text.font != cmd->data.text.font || into->data.text.y != cmd->data.text.y) return false;
+        if (strchr(first, '\n') || strchr(cmd_text, '\n')) return false;
+        if (into->data.text.x + (i32)first_len * into->data.text.font->glyph_width != cmd->data.text.x) return false;
+        
+        char* joined = (char*)malloc(first_len + second_len + 1);
+        if (!joined) return false;
+        memcpy(joined, first, first_len);
+        memcpy(joined + first_len, cmd_text, second_len + 1);
+        
+        i64 offset = cmd_list_push_text(out, joined);
+        free(joined);
+        if (offset < 0) return false;
+        
+        into->data.text.offset = (u32)offset;
+        i32 x1 = ENGINE_MIN(into->bounds.x, cmd->bounds.x);
+        i32 y1 = ENGINE_MIN(into->bounds.y, cmd->bounds.y);
+        i32 x2 = ENGINE_MAX(into->bounds.x + into->bounds.width, cmd->bounds.x + cmd->bounds.width);
+        i32 y2 = ENGINE_MAX(into->bounds.y + into->bounds.height, cmd->bounds.y + cmd->bounds.height);
+        into->bounds = graphics_rect(x1, y1, x2 - x1, y2 - y1);
+        return true;
+    }
+    
+    return false;
+}
+
+/* Helper: Sort-and-merge pass over a freshly recorded list */
+static void display_list_finalize(graphics_display_list_t* dl) {
+    graphics_cmd_list_t* in = &dl->list;
+    graphics_cmd_list_t out = {0};
+    
+    for (i32 i = 0; i < in->count; i++) {
+        const graphics_cmd_t* cmd = &in->cmds[i];
+        const char* cmd_text = cmd->type == GRAPHICS_CMD_TEXT ? in->text + cmd->data.text.offset : NULL;
+        bool merged = false;
+        
+        /* Look back for a compatible command; cmd may only move past commands it does not touch */
+        for (i32 j = out.count - 1; j >= 0 && j >= out.count - DISPLAY_LIST_MERGE_WINDOW; j--) {
+            graphics_cmd_t* prev = &out.cmds[j];
+            if (display_list_merge(&out, prev, cmd, cmd_text)) {
+                merged = true;
+                break;
+            }
+            if (bounds_overlap(&prev->bounds, &cmd->bounds)) break;
+        }
+        if (merged) continue;
+        
+        graphics_cmd_t* copy = cmd_list_push(&out);
+        if (!copy) {
+            cmd_list_free(&out);
+            return;
+        }
+        *copy = *cmd;
+        if (cmd_text) {
+            i64 offset = cmd_list_push_text(&out, cmd_text);
+            if (offset < 0) {
+                cmd_list_free(&out);
+                return;
+            }
+            copy->data.text.offset = (u32)offset;
+        }
+    }
+    
+    /* Drop text storage left behind by merged runs */
+    graphics_cmd_list_t compact = {0};
+    for (i32 i = 0; i < out.count; i++) {
+        graphics_cmd_t* cmd = &out.cmds[i];
+        if (cmd->type != GRAPHICS_CMD_TEXT) continue;
+        i64 offset = cmd_list_push_text(&compact, out.text + cmd->data.text.offset);
+        if (offset < 0) {
+            cmd_list_free(&compact);
+            cmd_list_free(&out);
+            return;
+        }
+        cmd->data.text.offset = (u32)offset;
+    }
+    free(out.text);
+    out.text = compact.text;
+    out.text_size = compact.text_size;
+    out.text_capacity = compact.text_capacity;
+    
+    cmd_list_free(in);
+    *in = out;
+}
+
+void graphics_end_record(graphics_context_t* ctx) {
+    if (!ctx || !ctx->record_saved || !ctx->record) return;
+    
+    graphics_display_list_t* dl = (graphics_display_list_t*)((char*)ctx->record - offsetof(graphics_display_list_t, list));
+    ctx->record = (ctx->record_saved == ctx->record) ? NULL : ctx->record_saved;
+    ctx->record_saved = NULL;
+    
+    display_list_finalize(dl);
+    dl->finalized = true;
+}
+
+void graphics_display_list_replay(const graphics_display_list_t* list, graphics_context_t* ctx) {
+    if (!list || !ctx || list->list.count == 0) return;
+    
+    /* A list still recording may grow under the loop below, even from this replay */
+    if (!list->finalized) {
+        ENGINE_LOG_WARN("Display list is still recording, not replaying it");
+        return;
+    }
+    
+    clip_box_t target;
+    if (!get_clip_box(ctx, &target)) return;
+    
+    for (i32 i = 0; i < list->list.count; i++) {
+        const graphics_cmd_t* cmd = &list->list.cmds[i];
+        
+        /* Clears ignore the clip, as when drawn directly */
+        if (cmd->type == GRAPHICS_CMD_CLEAR) {
+            graphics_clear(ctx, cmd->color);
+            continue;
+        }
+        
+        /* Recorded clip narrowed by the target's clip */
+        clip_box_t clip = {
+            ENGINE_MAX(cmd->clip.x, target.x1),
+            ENGINE_MAX(cmd->clip.y, target.y1),
+            ENGINE_MIN(cmd->clip.x + cmd->clip.width, target.x2),
+            ENGINE_MIN(cmd->clip.y + cmd->clip.height, target.y2),
+        };
+        if (clip.x1 >= clip.x2 || clip.y1 >= clip.y2) continue;
+        
+        /* Deferred or recording targets take the command as-is */
+        if (ctx->record) {
+            graphics_cmd_t* copy = defer_cmd_clipped(ctx, &clip, cmd->type, cmd->bounds.x, cmd->bounds.y,
+                                                     cmd->bounds.x + cmd->bounds.width,
+                                                     cmd->bounds.y + cmd->bounds.height, cmd->color);
+            if (!copy) continue;
+            copy->data = cmd->data;
+            if (cmd->type == GRAPHICS_CMD_TEXT) {
+                i64 offset = cmd_list_push_text(ctx->record, list->list.text + cmd->data.text.offset);
+                if (offset < 0) {
+                    ctx->record->count--;
+                    continue;
+                }
+                copy->data.text.offset = (u32)offset;
+            }
+            continue;
+        }
+        
+        damage_add_box(ctx, ENGINE_MAX(cmd->bounds.x, clip.x1), ENGINE_MAX(cmd->bounds.y, clip.y1),
+                       ENGINE_MIN(cmd->bounds.x + cmd->bounds.width, clip.x2),
+                       ENGINE_MIN(cmd->bounds.y + cmd->bounds.height, clip.y2));
+        
+        graphics_context_t immediate = *ctx;
+        immediate.clip_rect = graphics_rect(clip.x1, clip.y1, clip.x2 - clip.x1, clip.y2 - clip.y1);
+        immediate.clipping_enabled = true;
+        immediate.damage_tracking = false;
+        execute_cmd(&immediate, cmd, list->list.text);
+    }
 }
 
 /* Direct pixel access */
 u32* graphics_get_pixels(graphics_context_t* ctx) {
-    return ctx ? ctx->pixels : NULL;
+    if (!ctx) return NULL;
+    
+    /* Callers read the buffer directly, so pending commands must land first */
+    graphics_flush(ctx);
+    return ctx->pixels;
 }
 
 void graphics_set_pixels(graphics_context_t* ctx, const u32* pixels) {
     if (!ctx || !pixels) return;
-    memcpy(ctx->pixels, pixels, ctx->width * ctx->height * sizeof(u32));
+    
+    /* Everything queued for the tile renderer is overwritten */
+    if (ctx->deferred) {
+        ctx->deferred->list.count = 0;
+        ctx->deferred->list.text_size = 0;
+    }
+    view_sync(ctx);
+    for (i32 y = 0; y < ctx->height; y++) {
+        memcpy(ctx_row(ctx, y), pixels + (size_t)y * ctx->width, ctx->width * sizeof(u32));
+    }
+    damage_add_box(ctx, 0, 0, ctx->width, ctx->height);
+}
+
+/* Damage tracking */
+i32 graphics_get_damage(const graphics_context_t* ctx, const graphics_rect_t** out_rects) {
+    if (!ctx) return 0;
+    if (out_rects) *out_rects = ctx->damage;
+    return ctx->damage_count;
+}
+
+void graphics_add_damage(graphics_context_t* ctx, const graphics_rect_t* rect) {
+    if (!ctx || !rect) return;
+    damage_add_box(ctx, rect->x, rect->y, rect->x + rect->width, rect->y + rect->height);
+}
+
+void graphics_reset_damage(graphics_context_t* ctx) {
+    if (!ctx) return;
+    ctx->damage_count = 0;
 }
 
 /* Helper functions */
@@ -707,129 +3046,488 @@ bool graphics_rect_contains_point(const graphics_rect_t* rect, i32 x, i32 y) {
            y >= rect->y && y < rect->y + rect->height;
 }
 
-bool graphics_rect_intersects(const graphics_rect_t* a, const graphics_rect_t* b) {
-    if (!a || !b) return false;
-    return a->x < b->x + b->width && a->x + a->width > b->x &&
-           a->y < b->y + b->height && a->y + a->height > b->y;
+bool graphics_rect_intersects(const graphics_rect_t* a, const graphics_rect_t* b) {
+    if (!a || !b) return false;
+    return a->x < b->x + b->width && a->x + a->width > b->x &&
+           a->y < b->y + b->height && a->y + a->height > b->y;
+}
+
+/* Image operations - BMP and QOI loading */
+/* Helper: Opacity class of a run of pixels */
+static graphics_opacity_t classify_pixels(const u32* pixels, size_t count) {
+    bool opaque = true;
+    
+    for (size_t i = 0; i < count; i++) {
+        u32 a = pixels[i] >> 24;
+        if (a == 255) continue;
+        if (a != 0) return GRAPHICS_OPACITY_ALPHA;
+        opaque = false;
+    }
+    return opaque ? GRAPHICS_OPACITY_OPAQUE : GRAPHICS_OPACITY_BINARY;
+}
+
+/* Helpers: Little-endian header fields, safe at any alignment */
+static inline u16 read_u16_le(const u8* p) {
+    return (u16)(p[0] | (p[1] << 8));
+}
+
+static inline u32 read_u32_le(const u8* p) {
+    return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+
+/* Rows converted per pool task */
+#define BMP_ROWS_PER_TASK 64
+
+/* One BMP decode shared by the row-conversion tasks */
+typedef struct {
+    const u8* data;            /* First byte of pixel data */
+    size_t row_stride;         /* Padded file row size */
+    i32 bytes_per_pixel;
+    bool top_down;
+    graphics_image_t* image;
+    const graphics_span_ops_t* ops;
+    graphics_opacity_t opacity[];  /* Per task, combined afterwards */
+} bmp_decode_t;
+
+static void bmp_convert_rows(void* user, i32 index) {
+    bmp_decode_t* job = (bmp_decode_t*)user;
+    graphics_image_t* image = job->image;
+    i32 y_start = index * BMP_ROWS_PER_TASK;
+    i32 y_end = ENGINE_MIN(y_start + BMP_ROWS_PER_TASK, image->height);
+    
+    for (i32 y = y_start; y < y_end; y++) {
+        /* BMP rows are bottom-up unless the height was negative */
+        i32 src_y = job->top_down ? y : image->height - 1 - y;
+        const u8* src = job->data + (size_t)src_y * job->row_stride;
+        u32* dst = image->pixels + (size_t)y * image->width;
+        
+        if (job->bytes_per_pixel == 4) {
+            job->ops->swizzle_bgra(dst, src, image->width);
+        } else {
+            job->ops->swizzle_bgr(dst, src, image->width);
+        }
+    }
+    
+    graphics_opacity_t opacity = GRAPHICS_OPACITY_OPAQUE;
+    if (job->bytes_per_pixel == 4) {
+        opacity = classify_pixels(image->pixels + (size_t)y_start * image->width,
+                                  (size_t)(y_end - y_start) * image->width);
+    }
+    job->opacity[index] = opacity;
+}
+
+/* Helper: Validate a BMP held in memory and convert it into a new image */
+static graphics_image_t* bmp_decode(const u8* file, size_t size) {
+    if (size < 54) {
+        ENGINE_LOG_ERROR("Invalid BMP file (header too small)");
+        return NULL;
+    }
+    
+    /* Check BMP signature */
+    if (file[0] != 'B' || file[1] != 'M') {
+        ENGINE_LOG_ERROR("Not a BMP file");
+        return NULL;
+    }
+    
+    /* Extract image info */
+    u32 data_offset = read_u32_le(&file[10]);
+    i32 width = (i32)read_u32_le(&file[18]);
+    i32 height = (i32)read_u32_le(&file[22]);
+    u16 bits_per_pixel = read_u16_le(&file[28]);
+    u32 compression = read_u32_le(&file[30]);
+    
+    /* Handle negative height (top-down bitmap) */
+    bool top_down = false;
+    if (height < 0 && height != INT32_MIN) {
+        height = -height;
+        top_down = true;
+    }
+    
+    /* Validate */
+    if (width <= 0 || height <= 0) {
+        ENGINE_LOG_ERROR("Invalid BMP dimensions: %dx%d", width, height);
+        return NULL;
+    }
+    
+    if (compression != 0) {
+        ENGINE_LOG_ERROR("Compressed BMP not supported");
+        return NULL;
+    }
+    
+    if (bits_per_pixel != 24 && bits_per_pixel != 32) {
+        ENGINE_LOG_ERROR("Only 24-bit and 32-bit BMP supported, got %d-bit", bits_per_pixel);
+        return NULL;
+    }
+    
+    /* BMP rows are padded to multiples of 4 bytes; all of them must be in the file */
+    i32 bytes_per_pixel = bits_per_pixel / 8;
+    size_t row_stride = ((size_t)width * bytes_per_pixel + 3) & ~(size_t)3;
+    if (data_offset > size || (size - data_offset) / row_stride < (size_t)height) {
+        ENGINE_LOG_ERROR("BMP pixel data truncated (%dx%d, %zu bytes)", width, height, size);
+        return NULL;
+    }
+    
+    /* Create image */
+    graphics_image_t* image = graphics_create_image(width, height);
+    if (!image) {
+        ENGINE_LOG_ERROR("Failed to allocate image");
+        return NULL;
+    }
+    
+    i32 tasks = (height + BMP_ROWS_PER_TASK - 1) / BMP_ROWS_PER_TASK;
+    bmp_decode_t* job = (bmp_decode_t*)malloc(sizeof(bmp_decode_t) + (size_t)tasks * sizeof(graphics_opacity_t));
+    if (!job) {
+        ENGINE_LOG_ERROR("Failed to allocate BMP decode state");
+        graphics_destroy_image(image);
+        return NULL;
+    }
+    job->data = file + data_offset;
+    job->row_stride = row_stride;
+    job->bytes_per_pixel = bytes_per_pixel;
+    job->top_down = top_down;
+    job->image = image;
+    job->ops = select_span_ops();
+    
+    /* Rows convert straight into the image, in parallel when the pool is free */
+    pool_run(bmp_convert_rows, job, tasks);
+    
+    /* Classes are ordered, so the image class is the widest chunk class */
+    image->opacity = GRAPHICS_OPACITY_OPAQUE;
+    for (i32 i = 0; i < tasks; i++) {
+        image->opacity = ENGINE_MAX(image->opacity, job->opacity[i]);
+    }
+    
+    free(job);
+    return image;
+}
+
+/* QOI decoding
+ * Ops are tagged by their top bits (or a full 0xFE/0xFF byte), pixels are
+ * stored straight, and a 64-entry table of recent pixels is shared with the
+ * encoder. */
+#define QOI_HEADER_SIZE 14
+#define QOI_PADDING_SIZE 8
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF  0x40
+#define QOI_OP_LUMA  0x80
+#define QOI_OP_RUN   0xC0
+#define QOI_OP_RGB   0xFE
+#define QOI_OP_RGBA  0xFF
+#define QOI_MASK_2   0xC0
+
+/* Largest image either side accepts, keeps every size computation in range */
+#define QOI_MAX_PIXELS 400000000u
+
+static inline u32 read_u32_be(const u8* p) {
+    return ((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | p[3];
+}
+
+/* Helper: Slot of a packed pixel in the recent-pixel table */
+static inline u32 qoi_hash(u32 px) {
+    u32 r = px & 0xFF, g = (px >> 8) & 0xFF, b = (px >> 16) & 0xFF, a = px >> 24;
+    return (r * 3 + g * 5 + b * 7 + a * 11) & 63;
+}
+
+static graphics_image_t* qoi_decode(const u8* file, size_t size) {
+    if (size < QOI_HEADER_SIZE + QOI_PADDING_SIZE) {
+        ENGINE_LOG_ERROR("Invalid QOI file (header too small)");
+        return NULL;
+    }
+    
+    u32 width = read_u32_be(&file[4]);
+    u32 height = read_u32_be(&file[8]);
+    u8 channels = file[12];
+    if (width == 0 || height == 0 || (u64)width * height > QOI_MAX_PIXELS) {
+        ENGINE_LOG_ERROR("Invalid QOI dimensions: %ux%u", width, height);
+        return NULL;
+    }
+    if (channels != 3 && channels != 4) {
+        ENGINE_LOG_ERROR("Invalid QOI channel count: %d", channels);
+        return NULL;
+    }
+    
+    graphics_image_t* image = graphics_create_image((i32)width, (i32)height);
+    if (!image) {
+        ENGINE_LOG_ERROR("Failed to allocate image");
+        return NULL;
+    }
+    
+    /* The padding is never an op, so ops may read a few bytes without checks */
+    const u8* p = file + QOI_HEADER_SIZE;
+    const u8* end = file + size - QOI_PADDING_SIZE;
+    u32 index[64] = {0};
+    u32 px = 0xFF000000u;
+    u32* out = image->pixels;
+    u32* out_end = out + (size_t)width * height;
+    bool translucent = false;  /* Only QOI_OP_RGBA can lower alpha */
+    
+    while (out < out_end) {
+        if (p >= end) {
+            ENGINE_LOG_ERROR("QOI pixel data truncated");
+            graphics_destroy_image(image);
+            return NULL;
+        }
+        
+        u8 op = *p++;
+        if (op == QOI_OP_RGB) {
+            px = (px & 0xFF000000u) | ((u32)p[2] << 16) | ((u32)p[1] << 8) | p[0];
+            p += 3;
+        } else if (op == QOI_OP_RGBA) {
+            px = ((u32)p[3] << 24) | ((u32)p[2] << 16) | ((u32)p[1] << 8) | p[0];
+            translucent |= p[3] != 0xFF;
+            p += 4;
+        } else if ((op & QOI_MASK_2) == QOI_OP_INDEX) {
+            px = index[op];
+        } else if ((op & QOI_MASK_2) == QOI_OP_DIFF) {
+            u32 r = (px + ((op >> 4) & 3) - 2) & 0xFF;
+            u32 g = ((px >> 8) + ((op >> 2) & 3) - 2) & 0xFF;
+            u32 b = ((px >> 16) + (op & 3) - 2) & 0xFF;
+            px = (px & 0xFF000000u) | (b << 16) | (g << 8) | r;
+        } else if ((op & QOI_MASK_2) == QOI_OP_LUMA) {
+            i32 dg = (op & 0x3F) - 32;
+            i32 dr = dg + (*p >> 4) - 8;
+            i32 db = dg + (*p & 0x0F) - 8;
+            p++;
+            u32 r = (u32)((i32)(px & 0xFF) + dr) & 0xFF;
+            u32 g = (u32)((i32)((px >> 8) & 0xFF) + dg) & 0xFF;
+            u32 b = (u32)((i32)((px >> 16) & 0xFF) + db) & 0xFF;
+            px = (px & 0xFF000000u) | (b << 16) | (g << 8) | r;
+        } else {
+            /* Runs repeat the previous pixel, which is already in the table */
+            i32 run = ENGINE_MIN((i32)(op & 0x3F) + 1, (i32)(out_end - out));
+            for (i32 i = 0; i < run; i++) out[i] = px;
+            out += run;
+            continue;
+        }
+        
+        index[qoi_hash(px)] = px;
+        *out++ = px;
+    }
+    
+    /* The header's channel count is only a hint; trust the decoded alpha */
+    image->opacity = translucent ? classify_pixels(image->pixels, (size_t)width * height)
+                                 : GRAPHICS_OPACITY_OPAQUE;
+    return image;
+}
+
+graphics_image_t* graphics_load_image(const char* filename) {
+    return graphics_load_image_ex(filename, GRAPHICS_FORMAT_RGBA);
 }
 
-/* Image operations - BMP Loading */
-graphics_image_t* graphics_load_image(const char* filename) {
+graphics_image_t* graphics_load_image_ex(const char* filename, graphics_format_t format) {
     if (!filename) {
         ENGINE_LOG_ERROR("Invalid filename");
         return NULL;
     }
     
-    FILE* fp = fopen(filename, "rb");
-    if (!fp) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
         ENGINE_LOG_ERROR("Failed to open image file: %s", filename);
         return NULL;
     }
     
-    /* Read BMP header (14 bytes) */
-    u8 header[54];
-    if (fread(header, 1, 54, fp) != 54) {
-        ENGINE_LOG_ERROR("Invalid BMP file (header too small)");
-        fclose(fp);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ENGINE_LOG_ERROR("Not a regular file: %s", filename);
+        close(fd);
         return NULL;
     }
     
-    /* Check BMP signature */
-    if (header[0] != 'B' || header[1] != 'M') {
-        ENGINE_LOG_ERROR("Not a BMP file");
-        fclose(fp);
+    /* Map the file read-only; the decoder reads rows straight out of the page cache */
+    size_t size = (size_t)st.st_size;
+    void* file = size > 0 ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (file == MAP_FAILED) {
+        ENGINE_LOG_ERROR("Failed to map image file: %s", filename);
         return NULL;
     }
+    posix_madvise(file, size, POSIX_MADV_SEQUENTIAL);
     
-    /* Extract image info */
-    u32 data_offset = *(u32*)&header[10];
-    i32 width = *(i32*)&header[18];
-    i32 height = *(i32*)&header[22];
-    u16 bits_per_pixel = *(u16*)&header[28];
-    u32 compression = *(u32*)&header[30];
-    
-    /* Handle negative height (top-down bitmap) */
-    bool top_down = false;
-    if (height < 0) {
-        height = -height;
-        top_down = true;
+    /* QOI files start with their magic; anything else goes to the BMP reader */
+    ENGINE_PROFILE_BEGIN("decode_image");
+    graphics_image_t* image;
+    bool qoi = size >= 4 && memcmp(file, "qoif", 4) == 0;
+    if (qoi) {
+        image = qoi_decode((const u8*)file, size);
+    } else {
+        image = bmp_decode((const u8*)file, size);
     }
-    
-    /* Validate */
-    if (width <= 0 || height <= 0) {
-        ENGINE_LOG_ERROR("Invalid BMP dimensions: %dx%d", width, height);
-        fclose(fp);
+    munmap(file, size);
+    ENGINE_PROFILE_END();
+    if (!image) {
+        ENGINE_LOG_ERROR("Failed to load image: %s", filename);
         return NULL;
     }
     
-    if (compression != 0) {
-        ENGINE_LOG_ERROR("Compressed BMP not supported");
-        fclose(fp);
-        return NULL;
-    }
+    graphics_image_set_format(image, format);
     
-    if (bits_per_pixel != 24 && bits_per_pixel != 32) {
-        ENGINE_LOG_ERROR("Only 24-bit and 32-bit BMP supported, got %d-bit", bits_per_pixel);
-        fclose(fp);
-        return NULL;
+    ENGINE_LOG_INFO("Loaded %s image: %s (%dx%d)", qoi ? "QOI" : "BMP", filename, image->width, image->height);
+    return image;
+}
+
+/* QOI encoding: output goes through a small buffer so large images need no full-size copy */
+typedef struct {
+    FILE* fp;
+    u8 data[65536];
+    size_t length;
+    bool failed;
+} qoi_writer_t;
+
+static void qoi_flush(qoi_writer_t* w) {
+    if (w->length > 0 && fwrite(w->data, 1, w->length, w->fp) != w->length) {
+        w->failed = true;
     }
-    
-    /* Create image */
-    graphics_image_t* image = graphics_create_image(width, height);
-    if (!image) {
-        ENGINE_LOG_ERROR("Failed to allocate image");
-        fclose(fp);
-        return NULL;
+    w->length = 0;
+}
+
+/* Helper: Room for a pending run plus the longest op (QOI_OP_RGBA) */
+static inline u8* qoi_reserve(qoi_writer_t* w) {
+    if (w->length + 6 > sizeof(w->data)) qoi_flush(w);
+    return w->data + w->length;
+}
+
+/* Helper: Encode rows of pixels; pitch is in pixels */
+static bool qoi_encode(const u32* pixels, i32 width, i32 height, i32 pitch, graphics_format_t format,
+                       bool opaque, const char* filename) {
+    qoi_writer_t* w = (qoi_writer_t*)malloc(sizeof(qoi_writer_t));
+    if (!w) {
+        ENGINE_LOG_ERROR("Failed to allocate QOI writer");
+        return false;
+    }
+    w->fp = fopen(filename, "wb");
+    w->length = 0;
+    w->failed = false;
+    if (!w->fp) {
+        ENGINE_LOG_ERROR("Failed to create image file: %s", filename);
+        free(w);
+        return false;
     }
     
-    /* Seek to pixel data */
-    fseek(fp, data_offset, SEEK_SET);
-    
-    /* BMP rows are padded to multiples of 4 bytes */
-    i32 bytes_per_pixel = bits_per_pixel / 8;
-    i32 row_size = width * bytes_per_pixel;
-    i32 padded_row_size = (row_size + 3) & ~3;  /* Round up to multiple of 4 */
-    
-    u8* row_buffer = (u8*)malloc(padded_row_size);
-    if (!row_buffer) {
-        ENGINE_LOG_ERROR("Failed to allocate row buffer");
-        graphics_destroy_image(image);
-        fclose(fp);
-        return NULL;
+    /* Opaque images drop the alpha channel; decoders then assume 255 */
+    u8 channels = opaque ? 3 : 4;
+    u8* h = w->data;
+    memcpy(h, "qoif", 4);
+    for (i32 i = 0; i < 4; i++) {
+        h[4 + i] = (u8)((u32)width >> (24 - 8 * i));
+        h[8 + i] = (u8)((u32)height >> (24 - 8 * i));
     }
+    h[12] = channels;
+    h[13] = 0;  /* sRGB with linear alpha */
+    w->length = QOI_HEADER_SIZE;
     
-    /* Read pixels (BMP is bottom-up by default) */
-    for (i32 y = 0; y < height; y++) {
-        /* Calculate destination row (flip if bottom-up) */
-        i32 dest_y = top_down ? y : (height - 1 - y);
+    u32 index[64] = {0};
+    u32 prev = 0xFF000000u;
+    i32 run = 0;
+    size_t count = (size_t)width * height;
+    const u32* row = pixels;
+    i32 x = 0;
+    
+    for (size_t i = 0; i < count; i++) {
+        /* QOI stores straight alpha */
+        u32 px = convert_pixel(row[x], format, GRAPHICS_FORMAT_RGBA);
+        if (++x == width) {
+            x = 0;
+            row += pitch;
+        }
         
-        if (fread(row_buffer, 1, padded_row_size, fp) != (size_t)padded_row_size) {
-            ENGINE_LOG_ERROR("Failed to read image data at row %d", y);
-            free(row_buffer);
-            graphics_destroy_image(image);
-            fclose(fp);
-            return NULL;
+        if (px == prev) {
+            run++;
+            if (run == 62 || i + 1 == count) {
+                *qoi_reserve(w) = (u8)(QOI_OP_RUN | (run - 1));
+                w->length++;
+                run = 0;
+            }
+            continue;
         }
         
-        /* Convert pixels to RGBA */
-        for (i32 x = 0; x < width; x++) {
-            i32 src_offset = x * bytes_per_pixel;
-            
-            u8 b = row_buffer[src_offset + 0];
-            u8 g = row_buffer[src_offset + 1];
-            u8 r = row_buffer[src_offset + 2];
-            u8 a = (bits_per_pixel == 32) ? row_buffer[src_offset + 3] : 255;
+        u8* out = qoi_reserve(w);
+        if (run > 0) {
+            *out++ = (u8)(QOI_OP_RUN | (run - 1));
+            run = 0;
+        }
+        
+        u32 slot = qoi_hash(px);
+        if (index[slot] == px) {
+            *out++ = (u8)(QOI_OP_INDEX | slot);
+        } else {
+            index[slot] = px;
             
-            /* Pack into RGBA32 */
-            image->pixels[dest_y * width + x] = (a << 24) | (b << 16) | (g << 8) | r;
+            if ((px >> 24) == (prev >> 24)) {
+                i32 dr = (i8)((px & 0xFF) - (prev & 0xFF));
+                i32 dg = (i8)(((px >> 8) & 0xFF) - ((prev >> 8) & 0xFF));
+                i32 db = (i8)(((px >> 16) & 0xFF) - ((prev >> 16) & 0xFF));
+                i32 dr_dg = dr - dg;
+                i32 db_dg = db - dg;
+                
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    *out++ = (u8)(QOI_OP_DIFF | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+                } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+                    *out++ = (u8)(QOI_OP_LUMA | (dg + 32));
+                    *out++ = (u8)(((dr_dg + 8) << 4) | (db_dg + 8));
+                } else {
+                    *out++ = QOI_OP_RGB;
+                    *out++ = (u8)px;
+                    *out++ = (u8)(px >> 8);
+                    *out++ = (u8)(px >> 16);
+                }
+            } else {
+                *out++ = QOI_OP_RGBA;
+                *out++ = (u8)px;
+                *out++ = (u8)(px >> 8);
+                *out++ = (u8)(px >> 16);
+                *out++ = (u8)(px >> 24);
+            }
         }
+        w->length = (size_t)(out - w->data);
+        prev = px;
     }
     
-    free(row_buffer);
-    fclose(fp);
+    /* End marker: seven zero bytes and a one */
+    static const u8 padding[QOI_PADDING_SIZE] = {0, 0, 0, 0, 0, 0, 0, 1};
+    if (w->length + QOI_PADDING_SIZE > sizeof(w->data)) qoi_flush(w);
+    memcpy(w->data + w->length, padding, QOI_PADDING_SIZE);
+    w->length += QOI_PADDING_SIZE;
+    qoi_flush(w);
     
-    ENGINE_LOG_INFO("Loaded BMP image: %s (%dx%d, %d-bit)", filename, width, height, bits_per_pixel);
-    return image;
+    bool ok = !w->failed && fclose(w->fp) == 0;
+    if (w->failed) fclose(w->fp);
+    free(w);
+    
+    if (!ok) {
+        ENGINE_LOG_ERROR("Failed to write image file: %s", filename);
+        return false;
+    }
+    return true;
+}
+
+bool graphics_save_image_qoi(const graphics_image_t* image, const char* filename) {
+    if (!image || !filename) {
+        ENGINE_LOG_ERROR("Invalid image or filename");
+        return false;
+    }
+    return qoi_encode(image->pixels, image->width, image->height, image->pitch, image->format,
+                      image->opacity == GRAPHICS_OPACITY_OPAQUE, filename);
+}
+
+bool graphics_save_pixels_qoi(const u32* pixels, i32 width, i32 height, i32 pitch, graphics_format_t format,
+                              const char* filename) {
+    if (!pixels || width <= 0 || height <= 0 || pitch < width * 4 || !filename) {
+        ENGINE_LOG_ERROR("Invalid pixels or filename");
+        return false;
+    }
+    
+    i32 stride = pitch / 4;
+    bool opaque = true;
+    for (i32 y = 0; y < height && opaque; y++) {
+        const u32* row = pixels + (size_t)y * stride;
+        for (i32 x = 0; x < width; x++) {
+            if ((row[x] >> 24) != 0xFF) {
+                opaque = false;
+                break;
+            }
+        }
+    }
+    return qoi_encode(pixels, width, height, stride, format, opaque, filename);
 }
 
 graphics_image_t* graphics_create_image(i32 width, i32 height) {
@@ -846,40 +3544,606 @@ graphics_image_t* graphics_create_image(i32 width, i32 height) {
     
     image->width = width;
     image->height = height;
+    image->pitch = width;
+    image->opacity = GRAPHICS_OPACITY_BINARY;  /* Fully transparent */
+    image->format = GRAPHICS_FORMAT_RGBA;
+    image->mip = NULL;
     return image;
 }
 
 void graphics_destroy_image(graphics_image_t* image) {
     if (!image) return;
+    graphics_destroy_image(image->mip);
     if (image->pixels) free(image->pixels);
     free(image);
 }
 
+/* Helper: Blit one clipped row of image pixels in the image's format onto a row in the context's */
+static void blit_row_convert(const graphics_context_t* ctx, u32* dst, const u32* src, i32 count, graphics_format_t src_format) {
+    bool premultiplied = ctx->format == GRAPHICS_FORMAT_PREMULTIPLIED;
+    if (src_format == ctx->format) {
+        (premultiplied ? ctx->spans->blit_blend_premul : ctx->spans->blit_blend)(dst, src, count);
+        return;
+    }
+    
+    /* Formats differ: convert a chunk at a time, then use the context's kernel */
+    u32 chunk[256];
+    while (count > 0) {
+        i32 n = ENGINE_MIN(count, (i32)ENGINE_ARRAY_SIZE(chunk));
+        for (i32 i = 0; i < n; i++) {
+            chunk[i] = convert_pixel(src[i], src_format, ctx->format);
+        }
+        (premultiplied ? ctx->spans->blit_blend_premul : ctx->spans->blit_blend)(dst, chunk, n);
+        dst += n;
+        src += n;
+        count -= n;
+    }
+}
+
+/* Helper: True when opaque pixels read the same in both formats, which
+ * holds unless exactly one of them is BGRA */
+static inline bool same_channel_order(graphics_format_t a, graphics_format_t b) {
+    return (a == GRAPHICS_FORMAT_BGRA) == (b == GRAPHICS_FORMAT_BGRA);
+}
+
+/* Helper: Copy one row of opaque pixels, or with `masked` only those whose alpha
+ * is not 0, swapping red and blue when the formats order them differently */
+static void blit_row_solid(const graphics_context_t* ctx, u32* dst, const u32* src, i32 count,
+                           graphics_format_t src_format, bool masked) {
+    if (same_channel_order(src_format, ctx->format)) {
+        if (masked) {
+            ctx->spans->blit_masked(dst, src, count);
+        } else {
+            memcpy(dst, src, (size_t)count * sizeof(u32));
+        }
+        return;
+    }
+    
+    u32 chunk[256];
+    while (count > 0) {
+        i32 n = ENGINE_MIN(count, (i32)ENGINE_ARRAY_SIZE(chunk));
+        for (i32 i = 0; i < n; i++) {
+            chunk[i] = swap_red_blue(src[i]);
+        }
+        if (masked) {
+            ctx->spans->blit_masked(dst, chunk, n);
+        } else {
+            memcpy(dst, chunk, (size_t)n * sizeof(u32));
+        }
+        dst += n;
+        src += n;
+        count -= n;
+    }
+}
+
+/* Helper: Blit the part `src_rect` of an image at (x, y), clipped once.
+ * `opacity` describes the pixels inside src_rect. */
+static void blit_region(graphics_context_t* ctx, const graphics_image_t* image, const graphics_rect_t* src_rect,
+                        graphics_opacity_t opacity, i32 x, i32 y) {
+    clip_box_t clip;
+    if (!get_clip_box(ctx, &clip)) return;
+    
+    /* Clip the destination rect once, then walk whole rows */
+    i32 x1 = ENGINE_MAX(x, clip.x1);
+    i32 y1 = ENGINE_MAX(y, clip.y1);
+    i32 x2 = ENGINE_MIN(x + src_rect->width, clip.x2);
+    i32 y2 = ENGINE_MIN(y + src_rect->height, clip.y2);
+    if (x1 >= x2 || y1 >= y2) return;
+    damage_add_box(ctx, x1, y1, x2, y2);
+    
+    const u32* src = image->pixels + (size_t)(src_rect->y + y1 - y) * image->pitch + (src_rect->x + x1 - x);
+    i32 count = x2 - x1;
+    
+    /* Opaque and binary pixels are copied, needing at most a red/blue swap */
+    switch (opacity) {
+        case GRAPHICS_OPACITY_OPAQUE:
+        case GRAPHICS_OPACITY_BINARY:
+            for (i32 dy = y1; dy < y2; dy++, src += image->pitch) {
+                blit_row_solid(ctx, ctx_row(ctx, dy) + x1, src, count, image->format,
+                               opacity == GRAPHICS_OPACITY_BINARY);
+            }
+            break;
+        default:
+            for (i32 dy = y1; dy < y2; dy++, src += image->pitch) {
+                blit_row_convert(ctx, ctx_row(ctx, dy) + x1, src, count, image->format);
+            }
+            break;
+    }
+}
+
+/* Helper: Blit a whole image at (x, y) */
+static void blit_image(graphics_context_t* ctx, const graphics_image_t* image, i32 x, i32 y) {
+    graphics_rect_t all = { 0, 0, image->width, image->height };
+    blit_region(ctx, image, &all, image->opacity, x, y);
+}
+
 void graphics_draw_image(graphics_context_t* ctx, const graphics_image_t* image, i32 x, i32 y) {
     if (!ctx || !image) return;
     
-    for (i32 row = 0; row < image->height; row++) {
-        for (i32 col = 0; col < image->width; col++) {
-            u32 pixel = image->pixels[row * image->width + col];
-            graphics_color_t color = unpack_color(pixel);
-            graphics_draw_pixel(ctx, x + col, y + row, color);
+    if (ctx->record) {
+        graphics_cmd_t* cmd = defer_cmd(ctx, GRAPHICS_CMD_IMAGE, x, y, x + image->width, y + image->height, COLOR_WHITE);
+        if (cmd) {
+            cmd->data.image.image = image;
+            cmd->data.image.dest = graphics_rect(x, y, image->width, image->height);
+        }
+        return;
+    }
+    
+    blit_image(ctx, image, x, y);
+}
+
+void graphics_draw_layer(graphics_context_t* ctx, graphics_context_t* layer, i32 x, i32 y) {
+    if (!ctx || !layer || layer == ctx) return;
+    
+    /* The layer's pending commands land now; it must not change until ctx is flushed */
+    if (layer->deferred && layer->deferred->list.count > 0) {
+        graphics_flush(layer);
+    }
+    
+    if (ctx->record) {
+        graphics_cmd_t* cmd = defer_cmd(ctx, GRAPHICS_CMD_LAYER, x, y, x + layer->width, y + layer->height, COLOR_WHITE);
+        if (cmd) {
+            cmd->data.layer.layer = layer;
+            cmd->data.layer.x = x;
+            cmd->data.layer.y = y;
+        }
+        return;
+    }
+    
+    graphics_image_t view = { layer->pixels, layer->width, layer->height, GRAPHICS_OPACITY_ALPHA, layer->format, NULL, layer->pitch };
+    blit_image(ctx, &view, x, y);
+}
+
+/* Image scaling
+ * Destination pixels step through the source in 16.16 fixed point, clipped
+ * once per call, and are produced a chunk of a row at a time before going
+ * through the same blit kernels as unscaled images. Bilinear downscales of
+ * 2x or more first drop to a box-filtered mip level built on first use. */
+#define SCALE_CHUNK 256
+
+/* Helper: Half-size box-filtered copy of an image, averaged with premultiplied alpha */
+static graphics_image_t* image_build_mip(const graphics_image_t* image) {
+    i32 width = ENGINE_MAX(image->width / 2, 1);
+    i32 height = ENGINE_MAX(image->height / 2, 1);
+    graphics_image_t* mip = graphics_create_image(width, height);
+    if (!mip) {
+        ENGINE_LOG_ERROR("Failed to allocate mip level");
+        return NULL;
+    }
+    
+    bool straight = image->format != GRAPHICS_FORMAT_PREMULTIPLIED;
+    for (i32 y = 0; y < height; y++) {
+        const u32* row0 = image->pixels + (size_t)ENGINE_MIN(y * 2, image->height - 1) * image->pitch;
+        const u32* row1 = image->pixels + (size_t)ENGINE_MIN(y * 2 + 1, image->height - 1) * image->pitch;
+        for (i32 x = 0; x < width; x++) {
+            i32 x0 = ENGINE_MIN(x * 2, image->width - 1);
+            i32 x1 = ENGINE_MIN(x * 2 + 1, image->width - 1);
+            u32 texels[4] = { row0[x0], row0[x1], row1[x0], row1[x1] };
+            u32 out = 0;
+            
+            for (u32 shift = 0; shift < 32; shift += 8) {
+                u32 sum = 2;
+                for (i32 k = 0; k < 4; k++) {
+                    sum += ((straight ? premultiply(texels[k]) : texels[k]) >> shift) & 0xFF;
+                }
+                out |= (sum >> 2) << shift;
+            }
+            mip->pixels[(size_t)y * width + x] = straight ? unpremultiply(out) : out;
         }
     }
+    
+    mip->format = image->format;
+    mip->opacity = (image->opacity == GRAPHICS_OPACITY_OPAQUE) ? GRAPHICS_OPACITY_OPAQUE : GRAPHICS_OPACITY_ALPHA;
+    return mip;
+}
+
+/* Helper: Next mip level of an image, built once and shared by all threads */
+static const graphics_image_t* image_get_mip(const graphics_image_t* image) {
+    graphics_image_t* mip = __atomic_load_n(&image->mip, __ATOMIC_ACQUIRE);
+    if (mip || (image->width == 1 && image->height == 1)) return mip;
+    
+    pthread_mutex_lock(&g_mip_lock);
+    mip = image->mip;
+    if (!mip) {
+        mip = image_build_mip(image);
+        /* The mip chain is a cache; building it does not change the image */
+        __atomic_store_n(&((graphics_image_t*)image)->mip, mip, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&g_mip_lock);
+    return mip;
+}
+
+/* Helper: Blend a row of produced pixels by the source image's opacity */
+static void scale_emit(graphics_context_t* ctx, u32* dst, const u32* src, i32 count, const graphics_image_t* image, bool filtered) {
+    if (image->opacity == GRAPHICS_OPACITY_OPAQUE) {
+        blit_row_solid(ctx, dst, src, count, image->format, false);
+    } else if (image->opacity == GRAPHICS_OPACITY_BINARY && !filtered) {
+        blit_row_solid(ctx, dst, src, count, image->format, true);
+    } else {
+        blit_row_convert(ctx, dst, src, count, image->format);
+    }
 }
 
 void graphics_draw_image_scaled(graphics_context_t* ctx, const graphics_image_t* image, const graphics_rect_t* dest) {
+    graphics_draw_image_scaled_ex(ctx, image, dest, GRAPHICS_FILTER_NEAREST);
+}
+
+void graphics_draw_image_scaled_ex(graphics_context_t* ctx, const graphics_image_t* image, const graphics_rect_t* dest,
+                                   graphics_filter_t filter) {
     if (!ctx || !image || !dest) return;
     
-    /* Simple nearest-neighbor scaling */
-    for (i32 dy = 0; dy < dest->height; dy++) {
-        for (i32 dx = 0; dx < dest->width; dx++) {
-            i32 sx = dx * image->width / dest->width;
-            i32 sy = dy * image->height / dest->height;
-            u32 pixel = image->pixels[sy * image->width + sx];
-            graphics_color_t color = unpack_color(pixel);
-            graphics_draw_pixel(ctx, dest->x + dx, dest->y + dy, color);
+    if (ctx->record) {
+        graphics_cmd_t* cmd = defer_cmd(ctx, GRAPHICS_CMD_IMAGE_SCALED, dest->x, dest->y,
+                                        dest->x + dest->width, dest->y + dest->height, COLOR_WHITE);
+        if (cmd) {
+            cmd->data.image.image = image;
+            cmd->data.image.dest = *dest;
+            cmd->data.image.filter = (u32)filter;
+        }
+        return;
+    }
+    
+    if (dest->width <= 0 || dest->height <= 0) return;
+    
+    clip_box_t clip;
+    if (!get_clip_box(ctx, &clip)) return;
+    i32 x1 = ENGINE_MAX(dest->x, clip.x1);
+    i32 y1 = ENGINE_MAX(dest->y, clip.y1);
+    i32 x2 = ENGINE_MIN(dest->x + dest->width, clip.x2);
+    i32 y2 = ENGINE_MIN(dest->y + dest->height, clip.y2);
+    if (x1 >= x2 || y1 >= y2) return;
+    damage_add_box(ctx, x1, y1, x2, y2);
+    ENGINE_PROFILE_BEGIN("draw_image_scaled");
+    
+    bool bilinear = filter == GRAPHICS_FILTER_BILINEAR;
+    if (bilinear) {
+        while (image->width >= dest->width * 2 && image->height >= dest->height * 2) {
+            const graphics_image_t* mip = image_get_mip(image);
+            if (!mip) break;
+            image = mip;
+        }
+    }
+    
+    /* Bilinear steps in 16.16 and samples pixel centers */
+    i32 du = (i32)(((i64)image->width << 16) / dest->width);
+    i32 dv = (i32)(((i64)image->height << 16) / dest->height);
+    i32 u0 = (du >> 1) - 0x8000 + (x1 - dest->x) * du;
+    i32 v0 = (dv >> 1) - 0x8000;
+    
+    /* Nearest steps in 32.32, rounded up so that u >> 32 is exactly x * src / dest */
+    i64 step_u = (((i64)image->width << 32) / dest->width) + 1;
+    i64 step_v = (((i64)image->height << 32) / dest->height) + 1;
+    
+    u32 buffer[SCALE_CHUNK];
+    for (i32 y = y1; y < y2; y++) {
+        u32* dst = ctx_row(ctx, y) + x1;
+        
+        if (bilinear) {
+            i32 v = v0 + (y - dest->y) * dv;
+            u32 fy;
+            i32 sy = bilinear_texel(v, image->height - 1, &fy);
+            const u32* row0 = image->pixels + (size_t)sy * image->pitch;
+            const u32* row1 = image->pixels + (size_t)ENGINE_MIN(sy + 1, image->height - 1) * image->pitch;
+            
+            for (i32 x = x1, u = u0; x < x2; ) {
+                i32 n = ENGINE_MIN(x2 - x, SCALE_CHUNK);
+                ctx->spans->scale_bilinear(buffer, row0, row1, n, u, du, fy, image->width - 1);
+                scale_emit(ctx, dst, buffer, n, image, true);
+                x += n;
+                u += n * du;
+                dst += n;
+            }
+        } else {
+            const u32* row = image->pixels + (size_t)(((y - dest->y) * step_v) >> 32) * image->pitch;
+            i64 u = (x1 - dest->x) * step_u;
+            
+            for (i32 x = x1; x < x2; ) {
+                i32 n = ENGINE_MIN(x2 - x, SCALE_CHUNK);
+                for (i32 i = 0; i < n; i++, u += step_u) {
+                    buffer[i] = row[u >> 32];
+                }
+                scale_emit(ctx, dst, buffer, n, image, false);
+                x += n;
+                dst += n;
+            }
+        }
+    }
+    ENGINE_PROFILE_END();
+}
+
+/* Sprite atlases
+ * Images are copied into one page with a skyline packer: the page keeps the
+ * height of its top edge as a list of horizontal segments, and each sprite
+ * goes where its top edge ends lowest, leftmost on ties. */
+typedef struct {
+    i32 x, y, width;
+} atlas_segment_t;
+
+typedef struct {
+    graphics_rect_t rect;
+    graphics_opacity_t opacity;
+} atlas_sprite_t;
+
+struct graphics_atlas {
+    graphics_image_t* page;
+    atlas_segment_t* skyline;
+    i32 skyline_count;
+    i32 skyline_capacity;
+    atlas_sprite_t* sprites;
+    i32 sprite_count;
+    i32 sprite_capacity;
+};
+
+graphics_atlas_t* graphics_atlas_create(i32 width, i32 height, graphics_format_t format) {
+    graphics_atlas_t* atlas = (graphics_atlas_t*)calloc(1, sizeof(graphics_atlas_t));
+    if (!atlas) {
+        ENGINE_LOG_ERROR("Failed to allocate atlas");
+        return NULL;
+    }
+    
+    atlas->page = graphics_create_image(width, height);
+    atlas->skyline_capacity = 16;
+    atlas->skyline = (atlas_segment_t*)malloc((size_t)atlas->skyline_capacity * sizeof(atlas_segment_t));
+    if (!atlas->page || !atlas->skyline) {
+        ENGINE_LOG_ERROR("Failed to allocate %dx%d atlas page", width, height);
+        graphics_atlas_destroy(atlas);
+        return NULL;
+    }
+    
+    atlas->page->format = format;
+    atlas->skyline[0].x = 0;
+    atlas->skyline[0].y = 0;
+    atlas->skyline[0].width = width;
+    atlas->skyline_count = 1;
+    return atlas;
+}
+
+void graphics_atlas_destroy(graphics_atlas_t* atlas) {
+    if (!atlas) return;
+    graphics_destroy_image(atlas->page);
+    free(atlas->skyline);
+    free(atlas->sprites);
+    free(atlas);
+}
+
+/* Helper: Top of a width-wide sprite whose left edge sits on segment i, or -1 if it does not fit */
+static i32 atlas_fit(const graphics_atlas_t* atlas, i32 i, i32 width, i32 height) {
+    i32 x = atlas->skyline[i].x;
+    if (x + width > atlas->page->width) return -1;
+    
+    i32 y = 0;
+    for (i32 remaining = width; remaining > 0; i++) {
+        y = ENGINE_MAX(y, atlas->skyline[i].y);
+        if (y + height > atlas->page->height) return -1;
+        remaining -= atlas->skyline[i].width;
+    }
+    return y;
+}
+
+/* Helper: Raise the skyline under a sprite placed at (x, y) */
+static bool atlas_raise(graphics_atlas_t* atlas, i32 index, i32 x, i32 y, i32 width) {
+    if (atlas->skyline_count + 1 > atlas->skyline_capacity) {
+        i32 capacity = atlas->skyline_capacity * 2;
+        atlas_segment_t* skyline = (atlas_segment_t*)realloc(atlas->skyline, (size_t)capacity * sizeof(atlas_segment_t));
+        if (!skyline) return false;
+        atlas->skyline = skyline;
+        atlas->skyline_capacity = capacity;
+    }
+    
+    atlas_segment_t* sky = atlas->skyline;
+    memmove(&sky[index + 1], &sky[index], (size_t)(atlas->skyline_count - index) * sizeof(atlas_segment_t));
+    sky[index].x = x;
+    sky[index].y = y;
+    sky[index].width = width;
+    atlas->skyline_count++;
+    
+    /* Trim or drop the segments now under the new one */
+    for (i32 i = index + 1; i < atlas->skyline_count; ) {
+        i32 end = sky[index].x + sky[index].width;
+        if (sky[i].x >= end) break;
+        
+        i32 shrink = end - sky[i].x;
+        sky[i].x += shrink;
+        sky[i].width -= shrink;
+        if (sky[i].width > 0) break;
+        
+        memmove(&sky[i], &sky[i + 1], (size_t)(atlas->skyline_count - i - 1) * sizeof(atlas_segment_t));
+        atlas->skyline_count--;
+    }
+    
+    /* Join neighbours at the same height */
+    for (i32 i = 0; i + 1 < atlas->skyline_count; ) {
+        if (sky[i].y == sky[i + 1].y) {
+            sky[i].width += sky[i + 1].width;
+            memmove(&sky[i + 1], &sky[i + 2], (size_t)(atlas->skyline_count - i - 2) * sizeof(atlas_segment_t));
+            atlas->skyline_count--;
+        } else {
+            i++;
+        }
+    }
+    return true;
+}
+
+graphics_sprite_t graphics_atlas_add(graphics_atlas_t* atlas, const graphics_image_t* image) {
+    if (!atlas || !image) return GRAPHICS_SPRITE_NONE;
+    
+    i32 best = -1;
+    i32 best_x = 0, best_y = 0;
+    for (i32 i = 0; i < atlas->skyline_count; i++) {
+        i32 y = atlas_fit(atlas, i, image->width, image->height);
+        if (y < 0) continue;
+        if (best < 0 || y < best_y || (y == best_y && atlas->skyline[i].x < best_x)) {
+            best = i;
+            best_x = atlas->skyline[i].x;
+            best_y = y;
+        }
+    }
+    if (best < 0) {
+        ENGINE_LOG_WARN("Atlas full, no room for %dx%d image", image->width, image->height);
+        return GRAPHICS_SPRITE_NONE;
+    }
+    
+    if (atlas->sprite_count == atlas->sprite_capacity) {
+        i32 capacity = atlas->sprite_capacity ? atlas->sprite_capacity * 2 : 64;
+        atlas_sprite_t* sprites = (atlas_sprite_t*)realloc(atlas->sprites, (size_t)capacity * sizeof(atlas_sprite_t));
+        if (!sprites) {
+            ENGINE_LOG_ERROR("Failed to grow atlas sprite table");
+            return GRAPHICS_SPRITE_NONE;
+        }
+        atlas->sprites = sprites;
+        atlas->sprite_capacity = capacity;
+    }
+    if (!atlas_raise(atlas, best, best_x, best_y + image->height, image->width)) {
+        ENGINE_LOG_ERROR("Failed to grow atlas skyline");
+        return GRAPHICS_SPRITE_NONE;
+    }
+    
+    /* Copy rows in, converted to the page format */
+    graphics_image_t* page = atlas->page;
+    for (i32 y = 0; y < image->height; y++) {
+        u32* dst = page->pixels + (size_t)(best_y + y) * page->width + best_x;
+        memcpy(dst, image->pixels + (size_t)y * image->width, (size_t)image->width * sizeof(u32));
+        convert_pixels(dst, (size_t)image->width, image->format, page->format);
+    }
+    
+    atlas_sprite_t* sprite = &atlas->sprites[atlas->sprite_count];
+    sprite->rect = graphics_rect(best_x, best_y, image->width, image->height);
+    sprite->opacity = image->opacity;
+    return atlas->sprite_count++;
+}
+
+/* Helper: Order images tallest first, which packs a skyline much tighter */
+static const graphics_image_t* const* g_atlas_pack_images;
+static int atlas_pack_compare(const void* a, const void* b) {
+    const graphics_image_t* ia = g_atlas_pack_images[*(const i32*)a];
+    const graphics_image_t* ib = g_atlas_pack_images[*(const i32*)b];
+    if (ia->height != ib->height) return ib->height - ia->height;
+    if (ia->width != ib->width) return ib->width - ia->width;
+    return *(const i32*)a - *(const i32*)b;
+}
+
+i32 graphics_atlas_pack(graphics_atlas_t* atlas, const graphics_image_t* const* images, i32 count, graphics_sprite_t* out_sprites) {
+    if (!atlas || !images || count <= 0) return 0;
+    
+    i32* order = (i32*)malloc((size_t)count * sizeof(i32));
+    if (!order) {
+        ENGINE_LOG_ERROR("Failed to allocate atlas pack order");
+        return 0;
+    }
+    for (i32 i = 0; i < count; i++) order[i] = i;
+    
+    static pthread_mutex_t sort_lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_mutex_lock(&sort_lock);
+    g_atlas_pack_images = images;
+    qsort(order, (size_t)count, sizeof(i32), atlas_pack_compare);
+    pthread_mutex_unlock(&sort_lock);
+    
+    i32 packed = 0;
+    for (i32 i = 0; i < count; i++) {
+        graphics_sprite_t sprite = graphics_atlas_add(atlas, images[order[i]]);
+        if (out_sprites) out_sprites[order[i]] = sprite;
+        if (sprite != GRAPHICS_SPRITE_NONE) packed++;
+    }
+    
+    free(order);
+    return packed;
+}
+
+const graphics_image_t* graphics_atlas_get_image(const graphics_atlas_t* atlas) {
+    return atlas ? atlas->page : NULL;
+}
+
+graphics_rect_t graphics_atlas_get_rect(const graphics_atlas_t* atlas, graphics_sprite_t sprite) {
+    if (!atlas || sprite < 0 || sprite >= atlas->sprite_count) return graphics_rect(0, 0, 0, 0);
+    return atlas->sprites[sprite].rect;
+}
+
+/* Helper: Draw one sprite, immediately or into the record list */
+static void draw_sprite(graphics_context_t* ctx, const graphics_atlas_t* atlas, graphics_sprite_t sprite, i32 x, i32 y) {
+    if (sprite < 0 || sprite >= atlas->sprite_count) return;
+    const atlas_sprite_t* s = &atlas->sprites[sprite];
+    
+    if (ctx->record) {
+        graphics_cmd_t* cmd = defer_cmd(ctx, GRAPHICS_CMD_SPRITE, x, y, x + s->rect.width, y + s->rect.height, COLOR_WHITE);
+        if (cmd) {
+            cmd->data.sprite.atlas = atlas;
+            cmd->data.sprite.sprite = sprite;
+            cmd->data.sprite.x = x;
+            cmd->data.sprite.y = y;
+        }
+        return;
+    }
+    
+    blit_region(ctx, atlas->page, &s->rect, s->opacity, x, y);
+}
+
+void graphics_draw_sprite(graphics_context_t* ctx, const graphics_atlas_t* atlas, graphics_sprite_t sprite, i32 x, i32 y) {
+    if (!ctx || !atlas) return;
+    draw_sprite(ctx, atlas, sprite, x, y);
+}
+
+/* Sort key: atlas position, then submission order */
+typedef struct {
+    u32 key;
+    i32 index;
+} sprite_order_t;
+
+static int sprite_order_compare(const void* a, const void* b) {
+    const sprite_order_t* sa = (const sprite_order_t*)a;
+    const sprite_order_t* sb = (const sprite_order_t*)b;
+    if (sa->key != sb->key) return sa->key < sb->key ? -1 : 1;
+    return sa->index - sb->index;
+}
+
+void graphics_draw_sprites(graphics_context_t* ctx, const graphics_atlas_t* atlas, const graphics_sprite_draw_t* sprites, i32 count) {
+    if (!ctx || !atlas || !sprites || count <= 0) return;
+    
+    sprite_order_t stack_order[256];
+    sprite_order_t* order = stack_order;
+    if (count > (i32)ENGINE_ARRAY_SIZE(stack_order)) {
+        order = (sprite_order_t*)malloc((size_t)count * sizeof(sprite_order_t));
+    }
+    
+    /* Without scratch space, draw in submission order */
+    if (!order) {
+        for (i32 i = 0; i < count; i++) {
+            draw_sprite(ctx, atlas, sprites[i].sprite, sprites[i].x, sprites[i].y);
         }
+        return;
+    }
+    
+    /* Walk the page top to bottom so source rows stay in cache between sprites */
+    for (i32 i = 0; i < count; i++) {
+        graphics_rect_t rect = graphics_atlas_get_rect(atlas, sprites[i].sprite);
+        order[i].key = (u32)rect.y * (u32)atlas->page->width + (u32)rect.x;
+        order[i].index = i;
+    }
+    qsort(order, (size_t)count, sizeof(sprite_order_t), sprite_order_compare);
+    
+    for (i32 i = 0; i < count; i++) {
+        const graphics_sprite_draw_t* s = &sprites[order[i].index];
+        draw_sprite(ctx, atlas, s->sprite, s->x, s->y);
     }
+    
+    if (order != stack_order) free(order);
+}
+
+void graphics_image_set_format(graphics_image_t* image, graphics_format_t format) {
+    if (!image || image->format == format) return;
+    
+    convert_pixels(image->pixels, (size_t)image->width * image->height, image->format, format);
+    image->format = format;
+    
+    /* Mip levels are rebuilt in the new format when next needed */
+    image_drop_mip(image);
+}
+
+graphics_format_t graphics_image_get_format(const graphics_image_t* image) {
+    return image ? image->format : GRAPHICS_FORMAT_RGBA;
+}
+
+graphics_opacity_t graphics_image_get_opacity(const graphics_image_t* image) {
+    return image ? image->opacity : GRAPHICS_OPACITY_OPAQUE;
 }
 
 i32 graphics_image_get_width(const graphics_image_t* image) {
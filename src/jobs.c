@@ -0,0 +1,496 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/jobs.h"
+#include "../include/profiler.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#define JOBS_DEQUE_SIZE 1024   /* Jobs per deque, a power of two; a push to a full one runs inline */
+#define JOBS_SPIN_ROUNDS 64    /* Empty searches before a worker goes to sleep */
+#define JOBS_STACK_RANGES 64   /* parallel_for chunks kept on the stack */
+
+/* A queued job */
+typedef struct {
+    job_fn_t fn;
+    void* data;
+    job_counter_t* counter;
+} job_t;
+
+/* Jobs waiting on a counter */
+struct job_batch {
+    struct job_batch* next;
+    i32 count;
+    job_t jobs[];
+};
+
+/* Chase-Lev work-stealing deque
+ * The owner pushes and pops at the bottom; any thread steals from the top.
+ * Slots are read and written field by field with atomics because a thief
+ * may read a slot the owner is refilling; it then loses the race for top
+ * and throws the copy away. */
+typedef struct {
+    i64 top;
+    u8 pad0[56];
+    i64 bottom;
+    u8 pad1[56];
+    job_t slots[JOBS_DEQUE_SIZE];
+} job_deque_t;
+
+/* Global job system state */
+static struct {
+    job_deque_t* deques;       /* 0 belongs to the thread that called jobs_init, 1.. to workers */
+    i32 deque_count;
+    pthread_t threads[JOBS_MAX_WORKERS];
+    i32 worker_count;
+    bool initialized;
+    bool shutdown;
+    u32 generation;            /* Tells thread-local deque indices from a previous init apart */
+    
+    /* Jobs submitted by threads without a deque, in order */
+    pthread_mutex_t inject_lock;
+    job_t* inject;
+    i32 inject_head;
+    i32 inject_count;
+    i32 inject_capacity;
+    
+    /* Sleeping workers; queued counts jobs pushed and not yet taken */
+    pthread_mutex_t sleep_lock;
+    pthread_cond_t wake;
+    i32 queued;
+    i32 sleepers;
+} g_jobs = {
+    NULL, 0, {0}, 0, false, false, 0,
+    PTHREAD_MUTEX_INITIALIZER, NULL, 0, 0, 0,
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0
+};
+
+static __thread i32 t_deque = -1;
+static __thread u32 t_generation = 0;
+static __thread u32 t_rng = 0;
+
+/* Helper: The calling thread's deque index, -1 if it has none */
+static inline i32 own_deque(void) {
+    return t_generation == g_jobs.generation ? t_deque : -1;
+}
+
+static inline void slot_store(job_t* slot, const job_t* job) {
+    __atomic_store_n(&slot->fn, job->fn, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->data, job->data, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->counter, job->counter, __ATOMIC_RELAXED);
+}
+
+static inline void slot_load(job_t* slot, job_t* out) {
+    out->fn = __atomic_load_n(&slot->fn, __ATOMIC_RELAXED);
+    out->data = __atomic_load_n(&slot->data, __ATOMIC_RELAXED);
+    out->counter = __atomic_load_n(&slot->counter, __ATOMIC_RELAXED);
+}
+
+/* Helper: Push at the bottom, owner only; false when full */
+static bool deque_push(job_deque_t* d, const job_t* job) {
+    i64 b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED);
+    i64 t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+    if (b - t >= JOBS_DEQUE_SIZE) return false;
+    
+    slot_store(&d->slots[b & (JOBS_DEQUE_SIZE - 1)], job);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+/* Helper: Pop the newest job, owner only */
+static bool deque_pop(job_deque_t* d, job_t* out) {
+    i64 b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&d->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    i64 t = __atomic_load_n(&d->top, __ATOMIC_RELAXED);
+    
+    if (t > b) {
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    
+    slot_load(&d->slots[b & (JOBS_DEQUE_SIZE - 1)], out);
+    if (t == b) {
+        /* Last job: race thieves for it */
+        bool won = __atomic_compare_exchange_n(&d->top, &t, t + 1, false,
+                                               __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+        return won;
+    }
+    return true;
+}
+
+/* Helper: Take the oldest job, any thread */
+static bool deque_steal(job_deque_t* d, job_t* out) {
+    i64 t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    i64 b = __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE);
+    if (t >= b) return false;
+    
+    slot_load(&d->slots[t & (JOBS_DEQUE_SIZE - 1)], out);
+    return __atomic_compare_exchange_n(&d->top, &t, t + 1, false,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+/* Counters
+ * The lock covers pending and waiting. Finishing a job releases the lock
+ * as its last touch of the counter, and jobs_is_done waits for the lock
+ * too, so a counter can go out of scope as soon as a waiter sees zero. */
+static void counter_lock(job_counter_t* c) {
+    while (__atomic_exchange_n(&c->lock, 1, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(&c->lock, __ATOMIC_RELAXED)) {
+        }
+    }
+}
+
+static void counter_unlock(job_counter_t* c) {
+    __atomic_store_n(&c->lock, 0, __ATOMIC_RELEASE);
+}
+
+static void counter_add(job_counter_t* c, i32 count) {
+    counter_lock(c);
+    __atomic_store_n(&c->pending, c->pending + count, __ATOMIC_RELEASE);
+    counter_unlock(c);
+}
+
+static void push_job(const job_t* job);
+
+/* Helper: Queue a batch whose dependency is done, and free it */
+static void submit_batch(struct job_batch* batch) {
+    for (i32 i = 0; i < batch->count; i++) {
+        push_job(&batch->jobs[i]);
+    }
+    free(batch);
+}
+
+static void counter_finish(job_counter_t* c) {
+    counter_lock(c);
+    i32 left = c->pending - 1;
+    struct job_batch* ready = NULL;
+    if (left == 0) {
+        ready = c->waiting;
+        c->waiting = NULL;
+    }
+    __atomic_store_n(&c->pending, left, __ATOMIC_RELEASE);
+    counter_unlock(c);
+    
+    while (ready) {
+        struct job_batch* next = ready->next;
+        submit_batch(ready);
+        ready = next;
+    }
+}
+
+static void execute_job(const job_t* job) {
+    job->fn(job->data);
+    if (job->counter) counter_finish(job->counter);
+}
+
+/* Helper: Queue a job where the workers can find it and wake one */
+static void push_job(const job_t* job) {
+    if (g_jobs.worker_count == 0) {
+        execute_job(job);
+        return;
+    }
+    
+    i32 own = own_deque();
+    if (own >= 0) {
+        if (!deque_push(&g_jobs.deques[own], job)) {
+            execute_job(job);
+            return;
+        }
+    } else {
+        pthread_mutex_lock(&g_jobs.inject_lock);
+        if (g_jobs.inject_count == g_jobs.inject_capacity) {
+            i32 capacity = g_jobs.inject_capacity ? g_jobs.inject_capacity * 2 : 64;
+            job_t* grown = (job_t*)malloc((size_t)capacity * sizeof(job_t));
+            if (!grown) {
+                pthread_mutex_unlock(&g_jobs.inject_lock);
+                execute_job(job);
+                return;
+            }
+            for (i32 i = 0; i < g_jobs.inject_count; i++) {
+                grown[i] = g_jobs.inject[(g_jobs.inject_head + i) % g_jobs.inject_capacity];
+            }
+            free(g_jobs.inject);
+            g_jobs.inject = grown;
+            g_jobs.inject_head = 0;
+            g_jobs.inject_capacity = capacity;
+        }
+        g_jobs.inject[(g_jobs.inject_head + g_jobs.inject_count) % g_jobs.inject_capacity] = *job;
+        __atomic_store_n(&g_jobs.inject_count, g_jobs.inject_count + 1, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&g_jobs.inject_lock);
+    }
+    
+    __atomic_add_fetch(&g_jobs.queued, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&g_jobs.sleepers, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&g_jobs.sleep_lock);
+        pthread_cond_signal(&g_jobs.wake);
+        pthread_mutex_unlock(&g_jobs.sleep_lock);
+    }
+}
+
+/* Helper: Find a job: own deque first, then the shared queue, then steal */
+static bool take_job(job_t* out) {
+    if (g_jobs.deque_count == 0) return false;
+    
+    i32 own = own_deque();
+    bool found = own >= 0 && deque_pop(&g_jobs.deques[own], out);
+    
+    if (!found && __atomic_load_n(&g_jobs.inject_count, __ATOMIC_ACQUIRE) > 0) {
+        pthread_mutex_lock(&g_jobs.inject_lock);
+        if (g_jobs.inject_count > 0) {
+            *out = g_jobs.inject[g_jobs.inject_head];
+            g_jobs.inject_head = (g_jobs.inject_head + 1) % g_jobs.inject_capacity;
+            __atomic_store_n(&g_jobs.inject_count, g_jobs.inject_count - 1, __ATOMIC_RELEASE);
+            found = true;
+        }
+        pthread_mutex_unlock(&g_jobs.inject_lock);
+    }
+    
+    if (!found) {
+        /* Start at a random victim so thieves spread out */
+        t_rng = t_rng * 1664525u + 1013904223u;
+        i32 start = (i32)((t_rng >> 16) % (u32)g_jobs.deque_count);
+        for (i32 i = 0; i < g_jobs.deque_count && !found; i++) {
+            i32 victim = (start + i) % g_jobs.deque_count;
+            if (victim != own) found = deque_steal(&g_jobs.deques[victim], out);
+        }
+    }
+    
+    if (found) __atomic_sub_fetch(&g_jobs.queued, 1, __ATOMIC_SEQ_CST);
+    return found;
+}
+
+static void* job_worker(void* arg) {
+    t_deque = (i32)(intptr_t)arg;
+    t_generation = g_jobs.generation;
+    t_rng = (u32)t_deque * 2654435761u;
+    ENGINE_PROFILE_THREAD("job worker");
+    
+    i32 idle = 0;
+    for (;;) {
+        job_t job;
+        if (take_job(&job)) {
+            execute_job(&job);
+            idle = 0;
+            continue;
+        }
+        if (__atomic_load_n(&g_jobs.shutdown, __ATOMIC_ACQUIRE)) break;
+        if (++idle < JOBS_SPIN_ROUNDS) {
+            sched_yield();
+            continue;
+        }
+        
+        /* Announce the sleep before checking for work, so a push either
+         * sees the sleeper or is seen here */
+        pthread_mutex_lock(&g_jobs.sleep_lock);
+        __atomic_add_fetch(&g_jobs.sleepers, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&g_jobs.queued, __ATOMIC_SEQ_CST) <= 0 &&
+               !__atomic_load_n(&g_jobs.shutdown, __ATOMIC_ACQUIRE)) {
+            pthread_cond_wait(&g_jobs.wake, &g_jobs.sleep_lock);
+        }
+        __atomic_sub_fetch(&g_jobs.sleepers, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&g_jobs.sleep_lock);
+        idle = 0;
+    }
+    return NULL;
+}
+
+engine_result_t jobs_init(i32 worker_count) {
+    if (g_jobs.initialized) {
+        ENGINE_LOG_WARN("Job system already initialized");
+        return ENGINE_SUCCESS;
+    }
+    
+    if (worker_count == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        worker_count = cpus > 1 ? (i32)(cpus - 1) : 0;
+    }
+    worker_count = ENGINE_CLAMP(worker_count, 0, JOBS_MAX_WORKERS);
+    
+    g_jobs.initialized = true;
+    g_jobs.shutdown = false;
+    g_jobs.worker_count = 0;
+    g_jobs.generation++;
+    if (worker_count == 0) {
+        ENGINE_LOG_INFO("Job system running jobs inline");
+        return ENGINE_SUCCESS;
+    }
+    
+    g_jobs.deques = (job_deque_t*)calloc((size_t)worker_count + 1, sizeof(job_deque_t));
+    if (!g_jobs.deques) {
+        ENGINE_LOG_WARN("Failed to allocate job deques, running jobs inline");
+        return ENGINE_SUCCESS;
+    }
+    g_jobs.deque_count = worker_count + 1;
+    t_deque = 0;
+    t_generation = g_jobs.generation;
+    
+    i32 started = 0;
+    for (i32 i = 0; i < worker_count; i++) {
+        if (pthread_create(&g_jobs.threads[i], NULL, job_worker, (void*)(intptr_t)(i + 1)) != 0) {
+            ENGINE_LOG_WARN("Failed to start job worker %d", i);
+            break;
+        }
+        started++;
+    }
+    g_jobs.worker_count = started;
+    
+    ENGINE_LOG_INFO("Job system started: %d workers", g_jobs.worker_count);
+    return ENGINE_SUCCESS;
+}
+
+void jobs_shutdown(void) {
+    if (!g_jobs.initialized) return;
+    
+    pthread_mutex_lock(&g_jobs.sleep_lock);
+    __atomic_store_n(&g_jobs.shutdown, true, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&g_jobs.wake);
+    pthread_mutex_unlock(&g_jobs.sleep_lock);
+    
+    for (i32 i = 0; i < g_jobs.worker_count; i++) {
+        pthread_join(g_jobs.threads[i], NULL);
+    }
+    
+    /* Whatever the workers left behind runs here */
+    job_t job;
+    while (take_job(&job)) {
+        execute_job(&job);
+    }
+    
+    free(g_jobs.deques);
+    free(g_jobs.inject);
+    g_jobs.deques = NULL;
+    g_jobs.deque_count = 0;
+    g_jobs.inject = NULL;
+    g_jobs.inject_head = 0;
+    g_jobs.inject_count = 0;
+    g_jobs.inject_capacity = 0;
+    g_jobs.queued = 0;
+    g_jobs.worker_count = 0;
+    g_jobs.initialized = false;
+}
+
+i32 jobs_get_worker_count(void) {
+    return g_jobs.worker_count;
+}
+
+void jobs_run(const job_decl_t* jobs, i32 count, job_counter_t* counter) {
+    if (!jobs || count <= 0) return;
+    
+    if (counter) counter_add(counter, count);
+    for (i32 i = 0; i < count; i++) {
+        job_t job = { jobs[i].fn, jobs[i].data, counter };
+        push_job(&job);
+    }
+}
+
+void jobs_run_after(job_counter_t* dependency, const job_decl_t* jobs, i32 count,
+                    job_counter_t* counter) {
+    if (!jobs || count <= 0) return;
+    if (!dependency) {
+        jobs_run(jobs, count, counter);
+        return;
+    }
+    
+    struct job_batch* batch = (struct job_batch*)malloc(sizeof(struct job_batch) + (size_t)count * sizeof(job_t));
+    if (!batch) {
+        ENGINE_LOG_WARN("Failed to allocate job batch, waiting for its dependency");
+        jobs_wait(dependency);
+        jobs_run(jobs, count, counter);
+        return;
+    }
+    
+    if (counter) counter_add(counter, count);
+    batch->next = NULL;
+    batch->count = count;
+    for (i32 i = 0; i < count; i++) {
+        batch->jobs[i].fn = jobs[i].fn;
+        batch->jobs[i].data = jobs[i].data;
+        batch->jobs[i].counter = counter;
+    }
+    
+    counter_lock(dependency);
+    if (dependency->pending > 0) {
+        batch->next = dependency->waiting;
+        dependency->waiting = batch;
+        counter_unlock(dependency);
+        return;
+    }
+    counter_unlock(dependency);
+    submit_batch(batch);
+}
+
+bool jobs_is_done(const job_counter_t* counter) {
+    if (!counter) return true;
+    return __atomic_load_n(&counter->pending, __ATOMIC_ACQUIRE) == 0 &&
+           __atomic_load_n(&counter->lock, __ATOMIC_ACQUIRE) == 0;
+}
+
+void jobs_wait(job_counter_t* counter) {
+    while (!jobs_is_done(counter)) {
+        job_t job;
+        if (take_job(&job)) {
+            execute_job(&job);
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+/* One parallel_for chunk */
+typedef struct {
+    job_range_fn_t fn;
+    void* user_data;
+    i32 begin;
+    i32 end;
+} job_range_t;
+
+static void run_range(void* data) {
+    const job_range_t* range = (const job_range_t*)data;
+    range->fn(range->user_data, range->begin, range->end);
+}
+
+void jobs_parallel_for(i32 count, i32 grain, job_range_fn_t fn, void* user_data) {
+    if (!fn || count <= 0) return;
+    
+    i32 workers = g_jobs.worker_count;
+    if (grain <= 0) {
+        grain = count / ((workers + 1) * 4);
+        if (grain < 1) grain = 1;
+    }
+    i32 chunks = (count + grain - 1) / grain;
+    if (workers == 0 || chunks == 1) {
+        fn(user_data, 0, count);
+        return;
+    }
+    
+    job_range_t stack_ranges[JOBS_STACK_RANGES];
+    job_range_t* ranges = stack_ranges;
+    if (chunks > JOBS_STACK_RANGES) {
+        ranges = (job_range_t*)malloc((size_t)chunks * sizeof(job_range_t));
+        if (!ranges) {
+            fn(user_data, 0, count);
+            return;
+        }
+    }
+    
+    job_counter_t counter = {0};
+    counter_add(&counter, chunks);
+    for (i32 i = 0; i < chunks; i++) {
+        ranges[i].fn = fn;
+        ranges[i].user_data = user_data;
+        ranges[i].begin = i * grain;
+        ranges[i].end = ENGINE_MIN(count, (i + 1) * grain);
+        job_t job = { run_range, &ranges[i], &counter };
+        push_job(&job);
+    }
+    jobs_wait(&counter);
+    
+    if (ranges != stack_ranges) free(ranges);
+}
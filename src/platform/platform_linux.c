@@ -1,10 +1,13 @@
-#define _POSIX_C_SOURCE 199309L
+#define _POSIX_C_SOURCE 200809L
 
 #include "../include/platform.h"
 #include "../include/types.h"
+#include "../include/graphics.h"
+#include "../include/profiler.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/mman.h>
@@ -14,7 +17,19 @@
 #include <linux/kd.h>
 #include <termios.h>
 #include <time.h>
+#include <errno.h>
 #include <dirent.h>
+#include <ctype.h>
+
+/* Scripted input event for headless windows */
+typedef struct {
+    u32 frame;  /* Delivered once this many frames have been presented */
+    bool close;
+    engine_event_t event;
+} headless_event_t;
+
+/* Converts one row of RGBA pixels into framebuffer bytes at dst */
+typedef void (*present_convert_fn)(u8* dst, const u32* src, i32 count, i32 x, i32 y);
 
 /* Platform window structure */
 struct platform_window {
@@ -28,6 +43,24 @@ struct platform_window {
     u32 fb_size;
     struct fb_var_screeninfo vinfo;
     struct fb_fix_screeninfo finfo;
+    struct fb_var_screeninfo orig_vinfo;  /* Restored on destroy if we grew yres_virtual */
+    bool vinfo_changed;
+    
+    /* Page flipping: two yres-tall pages in yres_virtual, shown by panning */
+    bool can_flip;
+    i32 front_page;
+    
+    /* Row converter to the framebuffer format, picked at creation */
+    present_convert_fn convert;
+    const char* convert_name;
+    bool convert_simd;
+    
+    /* Headless windows present into memory and replay scripted input */
+    bool headless;
+    u32 frame_count;
+    headless_event_t* script;
+    i32 script_count;
+    i32 script_next;
     
     /* Input devices */
     i32 kbd_fd;
@@ -44,6 +77,14 @@ struct platform_window {
 
 /* Global state */
 static bool g_platform_initialized = false;
+#ifdef ENGINE_HEADLESS
+static bool g_headless = true;
+#else
+static bool g_headless = false;
+#endif
+static char g_headless_dump[256] = "";
+static i32 g_headless_dump_interval = 1;
+static char g_headless_script[256] = "";
 static platform_window_t* g_windows[16] = {0};
 static i32 g_window_count = 0;
 
@@ -118,11 +159,530 @@ static engine_key_t translate_key(u32 linux_key) {
     }
 }
 
+/* Row converters from engine RGBA to the framebuffer format. One is picked
+ * per window at creation; x and y place the row in the dither pattern. */
+
+/* 4x4 ordered dither thresholds, 0-15 */
+static const u8 g_bayer4[4][4] = {
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 },
+};
+
+static void convert_bgrx_scalar(u8* dst, const u32* src, i32 count, i32 x, i32 y) {
+    (void)x;
+    (void)y;
+    u32* out = (u32*)dst;
+    for (i32 i = 0; i < count; i++) {
+        u32 p = src[i];
+        out[i] = 0xFF000000u | ((p & 0xFF) << 16) | (p & 0xFF00) | ((p >> 16) & 0xFF);
+    }
+}
+
+static void convert_bgr_scalar(u8* dst, const u32* src, i32 count, i32 x, i32 y) {
+    (void)x;
+    (void)y;
+    for (i32 i = 0; i < count; i++, dst += 3) {
+        u32 p = src[i];
+        dst[0] = (p >> 16) & 0xFF;
+        dst[1] = (p >> 8) & 0xFF;
+        dst[2] = p & 0xFF;
+    }
+}
+
+static inline u16 pack_rgb565(u32 p) {
+    return (u16)(((p & 0xF8) << 8) | ((p >> 5) & 0x7E0) | ((p >> 19) & 0x1F));
+}
+
+static void convert_rgb565_scalar(u8* dst, const u32* src, i32 count, i32 x, i32 y) {
+    (void)x;
+    (void)y;
+    u16* out = (u16*)dst;
+    for (i32 i = 0; i < count; i++) {
+        out[i] = pack_rgb565(src[i]);
+    }
+}
+
+/* Helper: Add the threshold scaled to each channel's lost bits, saturating */
+static inline u32 dither_pixel(u32 p, u32 t) {
+    u32 r = (p & 0xFF) + (t >> 1);
+    u32 g = ((p >> 8) & 0xFF) + (t >> 2);
+    u32 b = ((p >> 16) & 0xFF) + (t >> 1);
+    if (r > 255) r = 255;
+    if (g > 255) g = 255;
+    if (b > 255) b = 255;
+    return r | (g << 8) | (b << 16);
+}
+
+static void convert_rgb565_dither_scalar(u8* dst, const u32* src, i32 count, i32 x, i32 y) {
+    const u8* row = g_bayer4[y & 3];
+    u16* out = (u16*)dst;
+    for (i32 i = 0; i < count; i++) {
+        out[i] = pack_rgb565(dither_pixel(src[i], row[(x + i) & 3]));
+    }
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PLATFORM_HAVE_X86_SIMD 1
+#include <cpuid.h>
+#include <immintrin.h>
+
+__attribute__((target("ssse3")))
+static void convert_bgrx_ssse3(u8* dst, const u32* src, i32 count, i32 x, i32 y) {
+    __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+    
+    i32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i p0 = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i p1 = _mm_loadu_si128((const __m128i*)(src + i + 4));
+        _mm_storeu_si128((__m128i*)(dst + (size_t)i * 4), _mm_or_si128(_mm_shuffle_epi8(p0, mask), alpha));
+        _mm_storeu_si128((__m128i*)(dst + (size_t)i * 4 + 16), _mm_or_si128(_mm_shuffle_epi8(p1, mask), alpha));
+    }
+    if (i < count) {
+        convert_bgrx_scalar(dst + (size_t)i * 4, src + i, count - i, x + i, y);
+    }
+}
+
+__attribute__((target("ssse3")))
+static void convert_bgr_ssse3(u8* dst, const u32* src, i32 count, i32 x, i32 y) {
+    __m128i mask = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    
+    /* Each step stores 16 bytes for 12 bytes of output, so stop while the
+     * spill still lands on pixels this row will write */
+    i32 i = 0;
+    for (; i + 6 <= count; i += 4) {
+        __m128i p = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + (size_t)i * 3), _mm_shuffle_epi8(p, mask));
+    }
+    if (i < count) {
+        convert_bgr_scalar(dst + (size_t)i * 3, src + i, count - i, x + i, y);
+    }
+}
+
+/* Helper: Eight RGBA pixels to eight RGB565 values */
+__attribute__((target("ssse3")))
+static inline __m128i pack_rgb565_ssse3(__m128i p0, __m128i p1) {
+    __m128i rmask = _mm_set1_epi32(0xF8);
+    __m128i gmask = _mm_set1_epi32(0x7E0);
+    __m128i bmask = _mm_set1_epi32(0x1F);
+    
+    __m128i v0 = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(p0, rmask), 8),
+                 _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p0, 5), gmask), _mm_and_si128(_mm_srli_epi32(p0, 19), bmask)));
+    __m128i v1 = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(p1, rmask), 8),
+                 _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p1, 5), gmask), _mm_and_si128(_mm_srli_epi32(p1, 19), bmask)));
+    
+    /* Sign-extend the low halves so the signed pack keeps them exactly */
+    v0 = _mm_srai_epi32(_mm_slli_epi32(v0, 16), 16);
+    v1 = _mm_srai_epi32(_mm_slli_epi32(v1, 16), 16);
+    return _mm_packs_epi32(v0, v1);
+}
+
+__attribute__((target("ssse3")))
+static void convert_rgb565_ssse3(u8* dst, const u32* src, i32 count, i32 x, i32 y) {
+    i32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i p0 = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i p1 = _mm_loadu_si128((const __m128i*)(src + i + 4));
+        _mm_storeu_si128((__m128i*)(dst + (size_t)i * 2), pack_rgb565_ssse3(p0, p1));
+    }
+    if (i < count) {
+        convert_rgb565_scalar(dst + (size_t)i * 2, src + i, count - i, x + i, y);
+    }
+}
+
+__attribute__((target("ssse3")))
+static void convert_rgb565_dither_ssse3(u8* dst, const u32* src, i32 count, i32 x, i32 y) {
+    /* The pattern repeats every four pixels, so one vector covers the row */
+    const u8* row = g_bayer4[y & 3];
+    u8 bias[16];
+    for (i32 k = 0; k < 4; k++) {
+        u8 t = row[(x + k) & 3];
+        bias[k * 4 + 0] = t >> 1;
+        bias[k * 4 + 1] = t >> 2;
+        bias[k * 4 + 2] = t >> 1;
+        bias[k * 4 + 3] = 0;
+    }
+    __m128i d = _mm_loadu_si128((const __m128i*)bias);
+    
+    i32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i p0 = _mm_adds_epu8(_mm_loadu_si128((const __m128i*)(src + i)), d);
+        __m128i p1 = _mm_adds_epu8(_mm_loadu_si128((const __m128i*)(src + i + 4)), d);
+        _mm_storeu_si128((__m128i*)(dst + (size_t)i * 2), pack_rgb565_ssse3(p0, p1));
+    }
+    if (i < count) {
+        convert_rgb565_dither_scalar(dst + (size_t)i * 2, src + i, count - i, x + i, y);
+    }
+}
+
+static bool cpu_has_ssse3(void) {
+    u32 eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+    return (ecx & bit_SSSE3) != 0;
+}
+#endif
+
+/* Helper: Pick the row converter for the framebuffer format. ENGINE_GRAPHICS_SIMD
+ * set to scalar or sse2 keeps the scalar rows; ENGINE_FB_DITHER=1 dithers 16 bpp. */
+static void select_present_convert(platform_window_t* window) {
+    bool simd = false;
+#ifdef PLATFORM_HAVE_X86_SIMD
+    const char* limit = getenv("ENGINE_GRAPHICS_SIMD");
+    simd = (!limit || strcmp(limit, "avx2") == 0) && cpu_has_ssse3();
+#endif
+    const char* dither_env = getenv("ENGINE_FB_DITHER");
+    bool dither = dither_env && strcmp(dither_env, "0") != 0;
+    
+    window->convert = NULL;
+    window->convert_name = "none";
+    switch (window->vinfo.bits_per_pixel) {
+        case 32:
+            window->convert = convert_bgrx_scalar;
+            window->convert_name = "BGRX";
+            break;
+        case 24:
+            window->convert = convert_bgr_scalar;
+            window->convert_name = "BGR";
+            break;
+        case 16:
+            window->convert = dither ? convert_rgb565_dither_scalar : convert_rgb565_scalar;
+            window->convert_name = dither ? "RGB565 dithered" : "RGB565";
+            break;
+        default:
+            fprintf(stderr, "[WARN] Unsupported framebuffer depth %d, nothing will be shown\n",
+                    window->vinfo.bits_per_pixel);
+            return;
+    }
+    
+#ifdef PLATFORM_HAVE_X86_SIMD
+    if (simd) {
+        if (window->convert == convert_bgrx_scalar) window->convert = convert_bgrx_ssse3;
+        else if (window->convert == convert_bgr_scalar) window->convert = convert_bgr_ssse3;
+        else if (window->convert == convert_rgb565_scalar) window->convert = convert_rgb565_ssse3;
+        else window->convert = convert_rgb565_dither_ssse3;
+    }
+#endif
+    window->convert_simd = simd;
+}
+
+/* Helper: Enable page flipping when the display is 32bpp BGRX and can pan
+ * between two pages. Runs before the framebuffer is mapped. */
+static void setup_page_flip(platform_window_t* window) {
+    struct fb_var_screeninfo* v = &window->vinfo;
+    window->can_flip = false;
+    window->front_page = 0;
+    
+    if (v->bits_per_pixel != 32 || v->red.offset != 16 || v->green.offset != 8 || v->blue.offset != 0 ||
+        v->red.length != 8 || v->green.length != 8 || v->blue.length != 8) {
+        return;
+    }
+    if (window->finfo.ypanstep == 0) return;
+    
+    /* Ask for a second page if the virtual screen is only one page tall */
+    if (v->yres_virtual < v->yres * 2) {
+        struct fb_var_screeninfo want = *v;
+        want.yres_virtual = v->yres * 2;
+        want.yoffset = 0;
+        if (ioctl(window->fb_fd, FBIOPUT_VSCREENINFO, &want) < 0 ||
+            ioctl(window->fb_fd, FBIOGET_VSCREENINFO, v) < 0 ||
+            ioctl(window->fb_fd, FBIOGET_FSCREENINFO, &window->finfo) < 0) {
+            ioctl(window->fb_fd, FBIOGET_VSCREENINFO, v);
+            return;
+        }
+        window->vinfo_changed = true;
+        if (v->yres_virtual < v->yres * 2) return;
+    }
+    
+    /* Pages must start on a pan step */
+    if (v->yres % window->finfo.ypanstep != 0) return;
+    
+    v->xoffset = 0;
+    v->yoffset = 0;
+    if (ioctl(window->fb_fd, FBIOPAN_DISPLAY, v) < 0) return;
+    
+    window->can_flip = true;
+}
+
+/* Key names accepted by headless scripts besides letters, digits and codes */
+static const struct {
+    const char* name;
+    engine_key_t key;
+} g_headless_keys[] = {
+    { "SPACE", ENGINE_KEY_SPACE }, { "ESCAPE", ENGINE_KEY_ESCAPE }, { "ENTER", ENGINE_KEY_ENTER },
+    { "TAB", ENGINE_KEY_TAB }, { "BACKSPACE", ENGINE_KEY_BACKSPACE }, { "INSERT", ENGINE_KEY_INSERT },
+    { "DELETE", ENGINE_KEY_DELETE }, { "LEFT", ENGINE_KEY_LEFT }, { "RIGHT", ENGINE_KEY_RIGHT },
+    { "UP", ENGINE_KEY_UP }, { "DOWN", ENGINE_KEY_DOWN }, { "LEFT_SHIFT", ENGINE_KEY_LEFT_SHIFT },
+    { "LEFT_CONTROL", ENGINE_KEY_LEFT_CONTROL }, { "LEFT_ALT", ENGINE_KEY_LEFT_ALT },
+};
+
+/* Helper: Parse a script key; returns false if unknown */
+static bool headless_parse_key(const char* text, engine_key_t* out_key) {
+    if (text[0] && !text[1] && isalnum((unsigned char)text[0])) {
+        *out_key = (engine_key_t)toupper((unsigned char)text[0]);
+        return true;
+    }
+    for (size_t i = 0; i < sizeof(g_headless_keys) / sizeof(g_headless_keys[0]); i++) {
+        if (strcasecmp(text, g_headless_keys[i].name) == 0) {
+            *out_key = g_headless_keys[i].key;
+            return true;
+        }
+    }
+    
+    char* end;
+    long code = strtol(text, &end, 10);
+    if (end == text || *end) return false;
+    *out_key = (engine_key_t)code;
+    return true;
+}
+
+/* Helper: Parse a script mouse button; returns false if unknown */
+static bool headless_parse_button(const char* text, engine_mouse_button_t* out_button) {
+    if (strcasecmp(text, "left") == 0) *out_button = ENGINE_MOUSE_BUTTON_LEFT;
+    else if (strcasecmp(text, "right") == 0) *out_button = ENGINE_MOUSE_BUTTON_RIGHT;
+    else if (strcasecmp(text, "middle") == 0) *out_button = ENGINE_MOUSE_BUTTON_MIDDLE;
+    else return false;
+    return true;
+}
+
+/* Helper: Append a parsed event to the window's script */
+static bool headless_push_event(platform_window_t* window, i32* capacity, const headless_event_t* event) {
+    if (window->script_count == *capacity) {
+        i32 new_capacity = *capacity ? *capacity * 2 : 32;
+        headless_event_t* events = (headless_event_t*)realloc(window->script, (size_t)new_capacity * sizeof(headless_event_t));
+        if (!events) return false;
+        window->script = events;
+        *capacity = new_capacity;
+    }
+    window->script[window->script_count++] = *event;
+    return true;
+}
+
+/* Helper: Load the input script; bad lines are reported and skipped */
+static void headless_load_script(platform_window_t* window, const char* path) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "[WARN] Failed to open input script: %s\n", path);
+        return;
+    }
+    
+    char line[256];
+    i32 line_number = 0;
+    i32 capacity = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        line_number++;
+        char* comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+        
+        char name[32], arg1[64] = "", arg2[64] = "";
+        unsigned frame;
+        i32 fields = sscanf(line, "%u %31s %63s %63s", &frame, name, arg1, arg2);
+        if (fields <= 0) continue;
+        
+        headless_event_t ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.frame = frame;
+        bool ok = fields >= 2;
+        
+        if (!ok) {
+            /* Missing event name */
+        } else if (strcmp(name, "key_press") == 0 || strcmp(name, "key_release") == 0 || strcmp(name, "key") == 0) {
+            ev.event.type = strcmp(name, "key_release") == 0 ? ENGINE_EVENT_KEY_RELEASE : ENGINE_EVENT_KEY_PRESS;
+            ok = fields >= 3 && headless_parse_key(arg1, &ev.event.data.key.key);
+            if (ok && strcmp(name, "key") == 0) {
+                ok = headless_push_event(window, &capacity, &ev);
+                ev.event.type = ENGINE_EVENT_KEY_RELEASE;
+            }
+        } else if (strcmp(name, "mouse_move") == 0) {
+            ev.event.type = ENGINE_EVENT_MOUSE_MOVE;
+            ok = fields >= 4;
+            ev.event.data.mouse_move.x = atoi(arg1);
+            ev.event.data.mouse_move.y = atoi(arg2);
+        } else if (strcmp(name, "mouse_press") == 0 || strcmp(name, "mouse_release") == 0) {
+            ev.event.type = strcmp(name, "mouse_press") == 0 ? ENGINE_EVENT_MOUSE_BUTTON_PRESS : ENGINE_EVENT_MOUSE_BUTTON_RELEASE;
+            ok = fields >= 3 && headless_parse_button(arg1, &ev.event.data.mouse_button.button);
+        } else if (strcmp(name, "wheel") == 0) {
+            ev.event.type = ENGINE_EVENT_MOUSE_WHEEL;
+            ok = fields >= 3;
+            ev.event.data.mouse_wheel.delta = (f32)atof(arg1);
+        } else if (strcmp(name, "close") == 0) {
+            ev.event.type = ENGINE_EVENT_WINDOW_CLOSE;
+            ev.close = true;
+        } else {
+            ok = false;
+        }
+        
+        if (ok) ok = headless_push_event(window, &capacity, &ev);
+        if (!ok) {
+            fprintf(stderr, "[WARN] %s:%d: ignoring script line\n", path, line_number);
+        }
+    }
+    fclose(fp);
+    
+    printf("[INFO] Loaded %d scripted input events from %s\n", window->script_count, path);
+}
+
+/* Helper: Write the visible page as a binary PPM */
+static bool headless_write_ppm(platform_window_t* window, const u8* page, const char* path) {
+    FILE* fp = fopen(path, "wb");
+    if (!fp) return false;
+    
+    u8* row = (u8*)malloc((size_t)window->width * 3);
+    bool ok = row && fprintf(fp, "P6\n%d %d\n255\n", window->width, window->height) > 0;
+    for (i32 y = 0; ok && y < window->height; y++) {
+        const u8* src = page + (size_t)y * window->finfo.line_length;
+        for (i32 x = 0; x < window->width; x++, src += 4) {
+            row[x * 3 + 0] = src[2];
+            row[x * 3 + 1] = src[1];
+            row[x * 3 + 2] = src[0];
+        }
+        ok = fwrite(row, 3, (size_t)window->width, fp) == (size_t)window->width;
+    }
+    free(row);
+    
+    if (fclose(fp) != 0) ok = false;
+    return ok;
+}
+
+/* Helper: Count a presented frame; headless windows dump it if due */
+static void end_frame(platform_window_t* window) {
+    /* Every present or flip ends a profiler frame, whoever calls it */
+    ENGINE_PROFILE_FRAME();
+    
+    u32 frame = window->frame_count++;
+    if (!window->headless || !g_headless_dump[0] || frame % (u32)g_headless_dump_interval != 0) return;
+    
+    char path[512];
+    snprintf(path, sizeof(path), g_headless_dump, (int)frame);
+    
+    const u8* page = window->fb_ptr + (size_t)window->front_page * window->height * window->finfo.line_length;
+    size_t length = strlen(path);
+    bool ok;
+    if (length >= 4 && strcasecmp(path + length - 4, ".qoi") == 0) {
+        ok = graphics_save_pixels_qoi((const u32*)page, window->width, window->height,
+                                      (i32)window->finfo.line_length, GRAPHICS_FORMAT_BGRA, path);
+    } else {
+        ok = headless_write_ppm(window, page, path);
+    }
+    if (!ok) {
+        fprintf(stderr, "[WARN] Failed to dump frame %u to %s\n", frame, path);
+    }
+}
+
+/* Helper: Set up a window that presents into memory. Both pages live in one
+ * allocation laid out like a 32bpp BGRX framebuffer, so presenting, direct
+ * rendering and flipping take the same paths as on a display. */
+static engine_result_t headless_window_init(platform_window_t* window, const platform_window_config_t* config) {
+    window->headless = true;
+    window->width = config->width > 0 ? config->width : 640;
+    window->height = config->height > 0 ? config->height : 480;
+    window->fb_fd = -1;
+    window->kbd_fd = -1;
+    window->mouse_fd = -1;
+    
+    struct fb_var_screeninfo* v = &window->vinfo;
+    v->xres = v->xres_virtual = (u32)window->width;
+    v->yres = (u32)window->height;
+    v->yres_virtual = (u32)window->height * 2;
+    v->bits_per_pixel = 32;
+    v->red.offset = 16;
+    v->green.offset = 8;
+    v->blue.offset = 0;
+    v->red.length = v->green.length = v->blue.length = 8;
+    window->finfo.line_length = (u32)window->width * 4;
+    window->can_flip = true;
+    
+    window->fb_size = v->yres_virtual * window->finfo.line_length;
+    window->fb_ptr = (u8*)calloc(1, window->fb_size);
+    if (!window->fb_ptr) return ENGINE_ERROR_OUT_OF_MEMORY;
+    
+    if (g_headless_script[0]) {
+        headless_load_script(window, g_headless_script);
+    }
+    return ENGINE_SUCCESS;
+}
+
+/* Helper: Deliver the script events that are due */
+static void headless_poll(platform_window_t* window) {
+    while (window->script_next < window->script_count &&
+           window->script[window->script_next].frame <= window->frame_count) {
+        const headless_event_t* ev = &window->script[window->script_next++];
+        if (ev->close) window->should_close = true;
+        
+        if (window->event_callback) {
+            window->event_callback(&ev->event, window->user_data);
+        }
+        
+        /* ESC to quit, as on a display */
+        if (ev->event.type == ENGINE_EVENT_KEY_PRESS && ev->event.data.key.key == ENGINE_KEY_ESCAPE) {
+            window->should_close = true;
+        }
+    }
+}
+
+/* Helper: Copy a setting string, empty for NULL */
+static void copy_setting(char* dst, size_t size, const char* src) {
+    snprintf(dst, size, "%s", src ? src : "");
+}
+
+/* Helper: True if a dump pattern has exactly one int conversion (%d, %05d, %x...)
+ * and no other directives but %%, so it is safe to hand to snprintf */
+static bool dump_pattern_valid(const char* pattern) {
+    i32 conversions = 0;
+    for (const char* p = pattern; *p; p++) {
+        if (*p != '%') continue;
+        p++;
+        if (*p == '%') continue;
+        
+        while (*p && strchr("-+ #0", *p)) p++;
+        while (isdigit((unsigned char)*p)) p++;
+        if (*p == '.') {
+            p++;
+            while (isdigit((unsigned char)*p)) p++;
+        }
+        if (!*p || !strchr("diuxXo", *p)) return false;
+        conversions++;
+    }
+    return conversions == 1;
+}
+
+void platform_set_headless(const platform_headless_config_t* config) {
+    g_headless = true;
+    copy_setting(g_headless_dump, sizeof(g_headless_dump), config ? config->dump_pattern : NULL);
+    if (g_headless_dump[0] && !dump_pattern_valid(g_headless_dump)) {
+        fprintf(stderr, "[WARN] Ignoring headless dump pattern \"%s\": it needs exactly one integer conversion such as %%05d\n",
+                g_headless_dump);
+        g_headless_dump[0] = '\0';
+    }
+    copy_setting(g_headless_script, sizeof(g_headless_script), config ? config->script_path : NULL);
+    g_headless_dump_interval = config && config->dump_interval > 1 ? config->dump_interval : 1;
+}
+
+bool platform_is_headless(void) {
+    return g_headless;
+}
+
+u32 platform_window_get_frame_count(const platform_window_t* window) {
+    return window ? window->frame_count : 0;
+}
+
 /* Platform initialization */
 engine_result_t platform_init(void) {
     if (g_platform_initialized) return ENGINE_SUCCESS;
     
-    printf("[INFO] Initializing framebuffer platform\n");
+    const char* backend = getenv("ENGINE_PLATFORM");
+    if (backend && strcmp(backend, "headless") == 0) {
+        const char* interval = getenv("ENGINE_HEADLESS_DUMP_INTERVAL");
+        platform_headless_config_t config = {
+            .dump_pattern = getenv("ENGINE_HEADLESS_DUMP"),
+            .dump_interval = interval ? atoi(interval) : 1,
+            .script_path = getenv("ENGINE_HEADLESS_SCRIPT"),
+        };
+        platform_set_headless(&config);
+    }
+    
+    printf("[INFO] Initializing %s platform\n", g_headless ? "headless" : "framebuffer");
     g_platform_initialized = true;
     return ENGINE_SUCCESS;
 }
@@ -130,7 +690,7 @@ engine_result_t platform_init(void) {
 void platform_shutdown(void) {
     if (!g_platform_initialized) return;
     
-    printf("[INFO] Shutting down framebuffer platform\n");
+    printf("[INFO] Shutting down %s platform\n", g_headless ? "headless" : "framebuffer");
     g_platform_initialized = false;
 }
 
@@ -141,6 +701,22 @@ engine_result_t platform_window_create(const platform_window_config_t* config, p
     platform_window_t* window = (platform_window_t*)calloc(1, sizeof(platform_window_t));
     if (!window) return ENGINE_ERROR_OUT_OF_MEMORY;
     
+    if (g_headless) {
+        engine_result_t result = headless_window_init(window, config);
+        if (result != ENGINE_SUCCESS) {
+            free(window);
+            return result;
+        }
+        select_present_convert(window);
+        window->event_callback = config->event_callback;
+        window->user_data = config->user_data;
+        
+        printf("[INFO] Headless window created: %dx%d\n", window->width, window->height);
+        register_window(window);
+        *out_window = window;
+        return ENGINE_SUCCESS;
+    }
+    
     /* Open framebuffer */
     window->fb_fd = open("/dev/fb0", O_RDWR);
     if (window->fb_fd < 0) {
@@ -160,6 +736,8 @@ engine_result_t platform_window_create(const platform_window_config_t* config, p
     
     window->width = window->vinfo.xres;
     window->height = window->vinfo.yres;
+    window->orig_vinfo = window->vinfo;
+    setup_page_flip(window);
     window->fb_size = window->vinfo.yres_virtual * window->finfo.line_length;
     
     /* Map framebuffer to memory */
@@ -173,6 +751,7 @@ engine_result_t platform_window_create(const platform_window_config_t* config, p
     
     /* Clear screen */
     memset(window->fb_ptr, 0, window->fb_size);
+    select_present_convert(window);
     
     /* Open keyboard device */
     window->kbd_fd = find_input_device("keyboard");
@@ -208,8 +787,10 @@ engine_result_t platform_window_create(const platform_window_config_t* config, p
         window->user_data = config->user_data;
     }
     
-    printf("[INFO] Framebuffer platform initialized: %dx%d, %d bpp\n", 
-           window->width, window->height, window->vinfo.bits_per_pixel);
+    printf("[INFO] Framebuffer platform initialized: %dx%d, %d bpp (%s%s)%s\n", 
+           window->width, window->height, window->vinfo.bits_per_pixel,
+           window->convert_name, window->convert_simd ? ", ssse3" : "",
+           window->can_flip ? ", page flipping" : "");
     
     register_window(window);
     *out_window = window;
@@ -221,6 +802,13 @@ void platform_window_destroy(platform_window_t* window) {
     
     unregister_window(window);
     
+    if (window->headless) {
+        free(window->script);
+        free(window->fb_ptr);
+        free(window);
+        return;
+    }
+    
     /* Restore terminal */
     tcsetattr(STDIN_FILENO, TCSAFLUSH, &window->orig_termios);
     ioctl(STDIN_FILENO, KDSKBMODE, window->orig_kbd_mode);
@@ -229,10 +817,16 @@ void platform_window_destroy(platform_window_t* window) {
     if (window->kbd_fd >= 0) close(window->kbd_fd);
     if (window->mouse_fd >= 0) close(window->mouse_fd);
     
-    /* Unmap and close framebuffer */
+    /* Unmap and close framebuffer, back at the mode we found it in */
     if (window->fb_ptr != MAP_FAILED) {
         munmap(window->fb_ptr, window->fb_size);
     }
+    if (window->vinfo_changed) {
+        ioctl(window->fb_fd, FBIOPUT_VSCREENINFO, &window->orig_vinfo);
+    } else if (window->can_flip && window->front_page != 0) {
+        window->vinfo.yoffset = 0;
+        ioctl(window->fb_fd, FBIOPAN_DISPLAY, &window->vinfo);
+    }
     if (window->fb_fd >= 0) {
         close(window->fb_fd);
     }
@@ -288,6 +882,10 @@ void platform_poll_events(void) {
     for (i32 w = 0; w < g_window_count; w++) {
         platform_window_t* window = g_windows[w];
         if (!window) continue;
+        if (window->headless) {
+            headless_poll(window);
+            continue;
+        }
         
         struct input_event ev;
         static i32 mouse_x = 0, mouse_y = 0;
@@ -363,40 +961,79 @@ void platform_poll_events(void) {
 }
 
 /* Buffer presentation */
-void platform_window_present_buffer(platform_window_t* window, const u32* buffer, i32 width, i32 height) {
-    if (!window || !buffer) return;
+static void present_row(platform_window_t* window, const u32* src, i32 x, i32 y, i32 count) {
+    if (!window->convert) return;
     
-    /* Convert RGBA to framebuffer format and write */
     i32 bpp = window->vinfo.bits_per_pixel / 8;
+    u8* dst = window->fb_ptr + (size_t)(y + window->front_page * window->height) * window->finfo.line_length +
+              (size_t)x * bpp;
+    window->convert(dst, src, count, x, y);
+}
+
+void platform_window_present_rects(platform_window_t* window, const u32* buffer, i32 width, i32 height,
+                                   i32 pitch, const platform_rect_t* rects, i32 rect_count) {
+    if (!window || !buffer || (!rects && rect_count > 0) || !window->fb_ptr) return;
     
-    for (i32 y = 0; y < height && y < window->height; y++) {
-        for (i32 x = 0; x < width && x < window->width; x++) {
-            u32 pixel = buffer[y * width + x];
-            
-            u8 r = pixel & 0xFF;
-            u8 g = (pixel >> 8) & 0xFF;
-            u8 b = (pixel >> 16) & 0xFF;
-            
-            i32 fb_offset = y * window->finfo.line_length + x * bpp;
-            
-            if (bpp == 4) {
-                /* 32-bit: BGRA */
-                window->fb_ptr[fb_offset + 0] = b;
-                window->fb_ptr[fb_offset + 1] = g;
-                window->fb_ptr[fb_offset + 2] = r;
-                window->fb_ptr[fb_offset + 3] = 0xFF;
-            } else if (bpp == 3) {
-                /* 24-bit: BGR */
-                window->fb_ptr[fb_offset + 0] = b;
-                window->fb_ptr[fb_offset + 1] = g;
-                window->fb_ptr[fb_offset + 2] = r;
-            } else if (bpp == 2) {
-                /* 16-bit: RGB565 */
-                u16 rgb565 = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
-                *(u16*)(window->fb_ptr + fb_offset) = rgb565;
-            }
+    /* Convert RGBA to framebuffer format, only inside the rects */
+    ENGINE_PROFILE_BEGIN("present");
+    i32 max_x = width < window->width ? width : window->width;
+    i32 max_y = height < window->height ? height : window->height;
+    
+    for (i32 i = 0; i < rect_count; i++) {
+        i32 x1 = rects[i].x > 0 ? rects[i].x : 0;
+        i32 y1 = rects[i].y > 0 ? rects[i].y : 0;
+        i32 x2 = rects[i].x + rects[i].width;
+        i32 y2 = rects[i].y + rects[i].height;
+        if (x2 > max_x) x2 = max_x;
+        if (y2 > max_y) y2 = max_y;
+        if (x1 >= x2 || y1 >= y2) continue;
+        
+        for (i32 y = y1; y < y2; y++) {
+            present_row(window, buffer + (size_t)y * pitch + x1, x1, y, x2 - x1);
         }
     }
+    ENGINE_PROFILE_END();
+    
+    end_frame(window);
+}
+
+void platform_window_present_buffer(platform_window_t* window, const u32* buffer, i32 width, i32 height) {
+    platform_rect_t full = { 0, 0, width, height };
+    platform_window_present_rects(window, buffer, width, height, width, &full, 1);
+}
+
+bool platform_window_get_back_surface(platform_window_t* window, platform_surface_t* out_surface) {
+    if (!window || !out_surface || !window->can_flip) return false;
+    
+    i32 back = 1 - window->front_page;
+    out_surface->pixels = (u32*)(window->fb_ptr + (size_t)back * window->height * window->finfo.line_length);
+    out_surface->width = window->width;
+    out_surface->height = window->height;
+    out_surface->pitch = (i32)window->finfo.line_length;
+    return true;
+}
+
+void platform_window_flip(platform_window_t* window) {
+    if (!window || !window->can_flip) return;
+    
+    i32 back = 1 - window->front_page;
+    if (window->headless) {
+        window->front_page = back;
+        end_frame(window);
+        return;
+    }
+    
+    window->vinfo.xoffset = 0;
+    window->vinfo.yoffset = (u32)(back * window->height);
+    ENGINE_PROFILE_BEGIN("present");
+    bool panned = ioctl(window->fb_fd, FBIOPAN_DISPLAY, &window->vinfo) >= 0;
+    ENGINE_PROFILE_END();
+    if (!panned) {
+        fprintf(stderr, "[WARN] Framebuffer pan failed\n");
+        return;
+    }
+    window->front_page = back;
+    end_frame(window);
 }
 
 /* Timing */
@@ -407,6 +1044,19 @@ void platform_sleep(u32 milliseconds) {
     nanosleep(&ts, NULL);
 }
 
+void platform_sleep_until(f64 time) {
+    if (time <= 0.0) return;
+    
+    /* Absolute sleep on the same clock as platform_get_time, so an
+     * interrupted sleep resumes without drifting */
+    struct timespec ts;
+    ts.tv_sec = (time_t)time;
+    ts.tv_nsec = (long)((time - (f64)ts.tv_sec) * 1000000000.0);
+    if (ts.tv_nsec >= 1000000000L) ts.tv_nsec = 999999999L;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
 u32 platform_get_ticks(void) {
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
@@ -0,0 +1,290 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/profiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#define PROFILER_RING_SIZE 16384  /* Zones kept per thread, a power of two */
+#define PROFILER_MAX_DEPTH 32
+#define PROFILER_MAX_THREADS 64
+
+/* A finished zone */
+typedef struct {
+    const char* name;
+    u64 start;  /* Nanoseconds, CLOCK_MONOTONIC */
+    u64 end;
+    i32 depth;
+} profiler_event_t;
+
+/* Per-thread recorder. Only the owning thread writes events and head;
+ * readers load head with acquire and drop any event the writer may have
+ * overwritten while they copied it. Recorders live until exit so traces
+ * keep the zones of threads that have finished. */
+typedef struct {
+    profiler_event_t events[PROFILER_RING_SIZE];
+    u64 head;  /* Events written so far */
+    
+    /* Open zones, owner only */
+    const char* open_names[PROFILER_MAX_DEPTH];
+    u64 open_starts[PROFILER_MAX_DEPTH];
+    i32 depth;
+    
+    i32 id;
+    char name[32];
+    u64 folded;  /* Events already in the frame stats, frame thread only */
+} profiler_thread_t;
+
+/* Global state */
+static profiler_thread_t* g_threads[PROFILER_MAX_THREADS];
+static i32 g_thread_count = 0;
+static pthread_mutex_t g_register_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread profiler_thread_t* t_thread = NULL;
+static u64 g_epoch = 0;  /* First timestamp, trace times are relative to it */
+
+/* Frame stats, only touched by the thread calling profiler_frame */
+static profiler_zone_stats_t g_stats[PROFILER_MAX_ZONES];
+static i32 g_stat_count = 0;
+static u64 g_frame_start = 0;
+static f64 g_frame_ms = 0.0;
+
+static inline u64 profiler_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+}
+
+/* Helper: The calling thread's recorder, registered on first use; NULL once
+ * PROFILER_MAX_THREADS threads have registered */
+static profiler_thread_t* get_thread(void) {
+    if (t_thread) return t_thread;
+    
+    pthread_mutex_lock(&g_register_lock);
+    if (g_thread_count < PROFILER_MAX_THREADS) {
+        profiler_thread_t* t = (profiler_thread_t*)calloc(1, sizeof(profiler_thread_t));
+        if (t) {
+            t->id = g_thread_count + 1;
+            snprintf(t->name, sizeof(t->name), "thread %d", t->id);
+            if (g_epoch == 0) g_epoch = profiler_now();
+            g_threads[g_thread_count] = t;
+            __atomic_store_n(&g_thread_count, g_thread_count + 1, __ATOMIC_RELEASE);
+            t_thread = t;
+        }
+    }
+    pthread_mutex_unlock(&g_register_lock);
+    return t_thread;
+}
+
+void profiler_begin(const char* name) {
+    profiler_thread_t* t = get_thread();
+    if (!t) return;
+    
+    /* Zones past the depth limit are counted so their ends still match */
+    if (t->depth < PROFILER_MAX_DEPTH) {
+        t->open_names[t->depth] = name;
+        t->open_starts[t->depth] = profiler_now();
+    }
+    t->depth++;
+}
+
+void profiler_end(void) {
+    profiler_thread_t* t = t_thread;
+    if (!t || t->depth == 0) return;
+    
+    t->depth--;
+    if (t->depth >= PROFILER_MAX_DEPTH) return;
+    
+    u64 head = t->head;
+    profiler_event_t* e = &t->events[head & (PROFILER_RING_SIZE - 1)];
+    e->name = t->open_names[t->depth];
+    e->start = t->open_starts[t->depth];
+    e->end = profiler_now();
+    e->depth = t->depth;
+    __atomic_store_n(&t->head, head + 1, __ATOMIC_RELEASE);
+}
+
+void profiler_set_thread_name(const char* name) {
+    profiler_thread_t* t = get_thread();
+    if (t && name) {
+        snprintf(t->name, sizeof(t->name), "%s", name);
+    }
+}
+
+/* Helper: Copy event index from a ring; false if it was overwritten */
+static bool read_event(const profiler_thread_t* t, u64 index, profiler_event_t* out) {
+    *out = t->events[index & (PROFILER_RING_SIZE - 1)];
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    u64 head = __atomic_load_n(&t->head, __ATOMIC_ACQUIRE);
+    return head - index < PROFILER_RING_SIZE;
+}
+
+/* Helper: Stats slot for a zone name, added on first sight */
+static profiler_zone_stats_t* find_stats(const char* name) {
+    for (i32 i = 0; i < g_stat_count; i++) {
+        if (g_stats[i].name == name || strcmp(g_stats[i].name, name) == 0) return &g_stats[i];
+    }
+    if (g_stat_count == PROFILER_MAX_ZONES) return NULL;
+    
+    profiler_zone_stats_t* s = &g_stats[g_stat_count++];
+    memset(s, 0, sizeof(*s));
+    s->name = name;
+    s->depth = PROFILER_MAX_DEPTH;
+    return s;
+}
+
+void profiler_frame(void) {
+    u64 now = profiler_now();
+    if (g_frame_start != 0) g_frame_ms = (f64)(now - g_frame_start) / 1e6;
+    g_frame_start = now;
+    
+    for (i32 i = 0; i < g_stat_count; i++) {
+        g_stats[i].ms = 0.0;
+        g_stats[i].calls = 0;
+    }
+    
+    /* Fold in every zone that ended since the last frame */
+    i32 thread_count = __atomic_load_n(&g_thread_count, __ATOMIC_ACQUIRE);
+    for (i32 ti = 0; ti < thread_count; ti++) {
+        profiler_thread_t* t = g_threads[ti];
+        u64 head = __atomic_load_n(&t->head, __ATOMIC_ACQUIRE);
+        u64 first = head > PROFILER_RING_SIZE ? head - PROFILER_RING_SIZE : 0;
+        if (t->folded > first) first = t->folded;
+        
+        for (u64 i = first; i < head; i++) {
+            profiler_event_t e;
+            if (!read_event(t, i, &e)) continue;
+            
+            profiler_zone_stats_t* s = find_stats(e.name);
+            if (!s) continue;
+            s->ms += (f64)(e.end - e.start) / 1e6;
+            s->calls++;
+            if (e.depth < s->depth) s->depth = e.depth;
+        }
+        t->folded = head;
+    }
+    
+    for (i32 i = 0; i < g_stat_count; i++) {
+        g_stats[i].avg_ms += (g_stats[i].ms - g_stats[i].avg_ms) * 0.1;
+    }
+}
+
+f64 profiler_get_frame_ms(void) {
+    return g_frame_ms;
+}
+
+i32 profiler_get_zone_stats(const profiler_zone_stats_t** out_stats) {
+    if (out_stats) *out_stats = g_stats;
+    return g_stat_count;
+}
+
+void profiler_draw_overlay(graphics_context_t* ctx, i32 x, i32 y) {
+    if (!ctx) return;
+    
+    i32 char_w, line_h;
+    graphics_measure_text("M", NULL, &char_w, &line_h);
+    line_h += 2;
+    
+    i32 name_w = 20 * char_w;
+    i32 width = name_w + 26 * char_w;
+    i32 rows = g_stat_count > 0 ? g_stat_count + 2 : 2;
+    graphics_rect_t panel = { x, y, width, rows * line_h + 8 };
+    graphics_fill_rect(ctx, &panel, graphics_rgba(0, 0, 0, 180));
+    
+    char text[64];
+    graphics_color_t title = graphics_rgb(255, 220, 90);
+    graphics_color_t body = graphics_rgb(220, 220, 220);
+    i32 ty = y + 4;
+    
+    snprintf(text, sizeof(text), "Frame %.2f ms", g_frame_ms);
+    graphics_draw_text(ctx, text, x + 4, ty, title, NULL);
+    ty += line_h;
+    
+    if (g_stat_count == 0) {
+#ifdef ENGINE_ENABLE_PROFILING
+        graphics_draw_text(ctx, "No zones recorded", x + 4, ty, body, NULL);
+#else
+        graphics_draw_text(ctx, "Profiling disabled", x + 4, ty, body, NULL);
+#endif
+        return;
+    }
+    
+    graphics_draw_text(ctx, "Zone", x + 4, ty, title, NULL);
+    graphics_draw_text(ctx, "     ms    avg calls", x + 4 + name_w, ty, title, NULL);
+    ty += line_h;
+    
+    for (i32 i = 0; i < g_stat_count; i++) {
+        const profiler_zone_stats_t* s = &g_stats[i];
+        i32 indent = (s->depth < 8 ? s->depth : 8) * char_w;
+        graphics_draw_text(ctx, s->name, x + 4 + indent, ty, body, NULL);
+        snprintf(text, sizeof(text), "%7.2f %6.2f %5d", s->ms, s->avg_ms, s->calls);
+        graphics_draw_text(ctx, text, x + 4 + name_w, ty, body, NULL);
+        ty += line_h;
+    }
+}
+
+/* Helper: Write a JSON string, escaping quotes, backslashes and controls */
+static void write_json_string(FILE* fp, const char* s) {
+    fputc('"', fp);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            fputc('\\', fp);
+            fputc(c, fp);
+        } else if (c < 0x20) {
+            fprintf(fp, "\\u%04x", c);
+        } else {
+            fputc(c, fp);
+        }
+    }
+    fputc('"', fp);
+}
+
+bool profiler_export_chrome_trace(const char* filename) {
+    if (!filename) return false;
+    
+    FILE* fp = fopen(filename, "w");
+    if (!fp) {
+        ENGINE_LOG_ERROR("Failed to create trace file: %s", filename);
+        return false;
+    }
+    
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first_event = true;
+    i32 written = 0;
+    
+    i32 thread_count = __atomic_load_n(&g_thread_count, __ATOMIC_ACQUIRE);
+    for (i32 ti = 0; ti < thread_count; ti++) {
+        profiler_thread_t* t = g_threads[ti];
+        
+        fprintf(fp, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+                first_event ? "" : ",\n", t->id);
+        write_json_string(fp, t->name);
+        fprintf(fp, "}}");
+        first_event = false;
+        
+        /* Complete events, times in microseconds */
+        u64 head = __atomic_load_n(&t->head, __ATOMIC_ACQUIRE);
+        u64 first = head > PROFILER_RING_SIZE ? head - PROFILER_RING_SIZE : 0;
+        for (u64 i = first; i < head; i++) {
+            profiler_event_t e;
+            if (!read_event(t, i, &e)) continue;
+            
+            fprintf(fp, ",\n{\"ph\":\"X\",\"name\":");
+            write_json_string(fp, e.name);
+            fprintf(fp, ",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    t->id, (f64)(e.start - g_epoch) / 1000.0, (f64)(e.end - e.start) / 1000.0);
+            written++;
+        }
+    }
+    
+    fprintf(fp, "\n]}\n");
+    if (fclose(fp) != 0) {
+        ENGINE_LOG_ERROR("Failed to write trace file: %s", filename);
+        return false;
+    }
+    
+    ENGINE_LOG_INFO("Wrote %d profiler zones to %s", written, filename);
+    return true;
+}
@@ -0,0 +1,195 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/simulation.h"
+#include "../include/platform.h"
+#include "../include/profiler.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define SIMULATION_SLOTS 4          /* Writer, handoff, and the reader's current and previous */
+#define SIMULATION_FRESH 0x80000000u  /* Handoff slot holds a snapshot the reader has not seen */
+#define SIMULATION_MAX_CATCHUP 8    /* Ticks run back to back before the schedule is dropped */
+
+/* Simulation structure
+ * Snapshots pass from writer to reader through a triple-buffered handoff:
+ * the writer fills its slot and swaps it into handoff, and the reader
+ * swaps its oldest slot for the handoff one when it is fresh. The reader
+ * also keeps the snapshot before the newest for blending, which is what
+ * the fourth slot is for. No slot is ever visible to both sides. */
+struct simulation {
+    simulation_config_t config;
+    f64 dt;
+    
+    u8* snapshots;                  /* SIMULATION_SLOTS snapshots, stride apart */
+    size_t stride;
+    u64 slot_tick[SIMULATION_SLOTS];
+    f64 slot_time[SIMULATION_SLOTS];  /* Scheduled time of the tick, platform clock */
+    
+    u32 handoff;                    /* Slot index, plus SIMULATION_FRESH */
+    u32 back;                       /* Writer only */
+    u32 front;                      /* Reader only */
+    u32 prev;
+    bool prev_valid;
+    
+    /* Writer only */
+    u64 tick;
+    f64 start_time;
+    u64 tick_count;                 /* Published for simulation_get_tick_count */
+    
+    pthread_t thread;
+    bool threaded;
+    bool running;
+};
+
+static inline void* slot_data(simulation_t* sim, u32 slot) {
+    return sim->snapshots + slot * sim->stride;
+}
+
+/* Helper: Take a snapshot into the writer's slot and hand it to the reader */
+static void publish(simulation_t* sim, f64 time) {
+    u32 slot = sim->back;
+    sim->config.snapshot(slot_data(sim, slot), sim->config.user_data);
+    sim->slot_tick[slot] = sim->tick;
+    sim->slot_time[slot] = time;
+    
+    u32 old = __atomic_exchange_n(&sim->handoff, slot | SIMULATION_FRESH, __ATOMIC_ACQ_REL);
+    sim->back = old & ~SIMULATION_FRESH;
+    __atomic_store_n(&sim->tick_count, sim->tick, __ATOMIC_RELEASE);
+}
+
+/* Helper: Run every tick due by now, up to SIMULATION_MAX_CATCHUP */
+static void run_due_ticks(simulation_t* sim, f64 now) {
+    i32 ran = 0;
+    f64 next = sim->start_time + (f64)(sim->tick + 1) * sim->dt;
+    while (next <= now) {
+        if (ran == SIMULATION_MAX_CATCHUP) {
+            /* Too far behind to catch up: carry on from now */
+            sim->start_time = now - (f64)sim->tick * sim->dt;
+            ENGINE_LOG_WARN("Simulation fell behind, skipping ahead");
+            break;
+        }
+        
+        ENGINE_PROFILE_BEGIN("simulation_tick");
+        sim->config.tick(sim->dt, sim->tick, sim->config.user_data);
+        sim->tick++;
+        publish(sim, next);
+        ENGINE_PROFILE_END();
+        
+        ran++;
+        next = sim->start_time + (f64)(sim->tick + 1) * sim->dt;
+    }
+}
+
+static void* simulation_thread(void* arg) {
+    simulation_t* sim = (simulation_t*)arg;
+    ENGINE_PROFILE_THREAD("simulation");
+    
+    while (__atomic_load_n(&sim->running, __ATOMIC_ACQUIRE)) {
+        run_due_ticks(sim, platform_get_time());
+        platform_sleep_until(sim->start_time + (f64)(sim->tick + 1) * sim->dt);
+    }
+    return NULL;
+}
+
+engine_result_t simulation_create(const simulation_config_t* config, simulation_t** out_sim) {
+    if (!config || !out_sim || !config->tick || !config->snapshot ||
+        config->snapshot_size == 0 || config->tick_rate < 0.0) {
+        ENGINE_LOG_ERROR("Invalid simulation parameters");
+        return ENGINE_ERROR_INVALID_PARAM;
+    }
+    
+    simulation_t* sim = (simulation_t*)calloc(1, sizeof(simulation_t));
+    if (!sim) {
+        ENGINE_LOG_ERROR("Failed to allocate simulation");
+        return ENGINE_ERROR_OUT_OF_MEMORY;
+    }
+    
+    /* Slots a cache line apart so the threads never share one */
+    sim->config = *config;
+    sim->dt = 1.0 / (config->tick_rate > 0.0 ? config->tick_rate : 60.0);
+    sim->stride = (config->snapshot_size + 63) & ~(size_t)63;
+    sim->snapshots = (u8*)calloc(SIMULATION_SLOTS, sim->stride);
+    if (!sim->snapshots) {
+        ENGINE_LOG_ERROR("Failed to allocate simulation snapshots");
+        free(sim);
+        return ENGINE_ERROR_OUT_OF_MEMORY;
+    }
+    
+    /* The reader starts on the tick 0 snapshot */
+    sim->front = 0;
+    sim->prev = 1;
+    sim->handoff = 2;
+    sim->back = 3;
+    sim->start_time = platform_get_time();
+    config->snapshot(slot_data(sim, sim->front), config->user_data);
+    sim->slot_time[sim->front] = sim->start_time;
+    
+    if (config->threaded) {
+        sim->running = true;
+        if (pthread_create(&sim->thread, NULL, simulation_thread, sim) != 0) {
+            ENGINE_LOG_ERROR("Failed to start simulation thread");
+            free(sim->snapshots);
+            free(sim);
+            return ENGINE_ERROR;
+        }
+        sim->threaded = true;
+    }
+    
+    *out_sim = sim;
+    ENGINE_LOG_INFO("Simulation created: %.1f ticks/s%s", 1.0 / sim->dt,
+                    sim->threaded ? " on its own thread" : "");
+    return ENGINE_SUCCESS;
+}
+
+void simulation_destroy(simulation_t* sim) {
+    if (!sim) return;
+    
+    if (sim->threaded) {
+        __atomic_store_n(&sim->running, false, __ATOMIC_RELEASE);
+        pthread_join(sim->thread, NULL);
+    }
+    
+    free(sim->snapshots);
+    free(sim);
+}
+
+void simulation_update(simulation_t* sim) {
+    if (!sim || sim->threaded) return;
+    run_due_ticks(sim, platform_get_time());
+}
+
+void simulation_acquire(simulation_t* sim, simulation_frame_t* out_frame) {
+    if (!sim || !out_frame) return;
+    
+    /* Retire the previous snapshot in exchange for the fresh one */
+    if (__atomic_load_n(&sim->handoff, __ATOMIC_ACQUIRE) & SIMULATION_FRESH) {
+        u32 got = __atomic_exchange_n(&sim->handoff, sim->prev, __ATOMIC_ACQ_REL);
+        sim->prev = sim->front;
+        sim->front = got & ~SIMULATION_FRESH;
+        sim->prev_valid = true;
+    }
+    
+    u32 prev = sim->prev_valid ? sim->prev : sim->front;
+    out_frame->previous = slot_data(sim, prev);
+    out_frame->current = slot_data(sim, sim->front);
+    out_frame->tick = sim->slot_tick[sim->front];
+    
+    /* Blend across the gap between the two snapshots, which spans several
+     * ticks when the renderer misses some */
+    f64 span = sim->slot_time[sim->front] - sim->slot_time[prev];
+    f64 alpha = 1.0;
+    if (span > 0.0) {
+        alpha = (platform_get_time() - sim->slot_time[sim->front]) / span;
+    }
+    out_frame->alpha = (f32)ENGINE_CLAMP(alpha, 0.0, 1.0);
+}
+
+u64 simulation_get_tick_count(const simulation_t* sim) {
+    if (!sim) return 0;
+    return __atomic_load_n(&sim->tick_count, __ATOMIC_ACQUIRE);
+}
+
+f64 simulation_get_tick_interval(const simulation_t* sim) {
+    return sim ? sim->dt : 0.0;
+}
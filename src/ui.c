@@ -1,10 +1,12 @@
 #include "../include/ui.h"
+#include "../include/profiler.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
 #define UI_MAX_LAYOUT_STACK 32
 #define UI_MAX_INPUT_BUFFER 256
+#define UI_ARENA_CAPACITY ((size_t)16 << 10)  /* Bytes per frame before the arena grows */
 
 /* Layout state */
 typedef struct {
@@ -29,7 +31,7 @@ typedef struct {
     ui_popup_cmd_type_t type;
     graphics_rect_t rect;
     graphics_color_t color;
-    char text[64];
+    const char* text;  /* In the frame arena */
     graphics_font_t* font;
 } ui_popup_cmd_t;
 
@@ -85,6 +87,9 @@ struct ui_context {
     
     /* Frame counter for animations */
     i32 frame_count;
+    
+    /* Per-frame scratch memory, swapped in ui_begin_frame */
+    frame_arena_t* arena;
 };
 
 /* Helper: Hash string to ID */
@@ -152,18 +157,33 @@ ui_context_t* ui_create_context(graphics_context_t* gfx) {
     ctx->row_height = 24;
     ctx->same_line = false;
     
+    ctx->arena = frame_arena_create(UI_ARENA_CAPACITY);
+    if (!ctx->arena) {
+        free(ctx);
+        return NULL;
+    }
+    
     return ctx;
 }
 
 void ui_destroy_context(ui_context_t* ctx) {
     if (!ctx) return;
+    frame_arena_destroy(ctx->arena);
     free(ctx);
 }
 
+frame_arena_t* ui_get_frame_arena(ui_context_t* ctx) {
+    return ctx ? ctx->arena : NULL;
+}
+
 void ui_begin_frame(ui_context_t* ctx) {
     if (!ctx) return;
     
+    /* The zone covers all widget drawing until ui_end_frame */
+    ENGINE_PROFILE_BEGIN("ui_frame");
+    
     /* Reset per-frame state */
+    frame_arena_swap(ctx->arena);
     ctx->hot_id = 0;
     /* DON'T clear input_char here - widgets need to read it! */
     ctx->cursor_x = ctx->style.spacing;
@@ -205,6 +225,7 @@ void ui_end_frame(ui_context_t* ctx) {
     
     /* Clear input char AFTER widgets have processed it */
     ctx->input_char = 0;
+    ENGINE_PROFILE_END();
 }
 
 /* Input */
@@ -749,13 +770,17 @@ static void ui_popup_add_rect(ui_context_t* ctx, graphics_rect_t rect, graphics_
 /* Helper to add popup text */
 static void ui_popup_add_text(ui_context_t* ctx, const char* text, i32 x, i32 y, graphics_color_t color, graphics_font_t* font) {
     if (ctx->popup_command_count < UI_MAX_POPUP_COMMANDS) {
+        /* Copied whole: the caller's string may not outlive the frame */
+        char* copy = frame_arena_strdup(ctx->arena, text);
+        if (!copy) return;
+        
         ui_popup_cmd_t* cmd = &ctx->popup_commands[ctx->popup_command_count++];
         cmd->type = UI_POPUP_CMD_TEXT;
         cmd->rect.x = x;
         cmd->rect.y = y;
         cmd->color = color;
         cmd->font = font;
-        strncpy(cmd->text, text, sizeof(cmd->text) - 1);
+        cmd->text = copy;
     }
 }
 
@@ -1,6 +1,7 @@
 #include "../include/window.h"
 #include "../include/graphics.h"
 #include "../include/ui.h"
+#include "../include/profiler.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -240,6 +241,7 @@ void window_manager_update(window_manager_t* wm, i32 mouse_x, i32 mouse_y, bool
 /* Window manager render (draws all windows) */
 void window_manager_render(window_manager_t* wm, graphics_context_t* gfx, graphics_font_t* font) {
     if (!wm || !gfx) return;
+    ENGINE_PROFILE_BEGIN("window_manager_render");
     
     /* Render windows from back to front */
     for (i32 i = 0; i < wm->window_count; i++) {
@@ -282,6 +284,7 @@ void window_manager_render(window_manager_t* wm, graphics_context_t* gfx, graphi
             graphics_fill_rect(gfx, &handle, graphics_rgb(100, 100, 105));
         }
     }
+    ENGINE_PROFILE_END();
 }
 
 /* Window content area begin/end */
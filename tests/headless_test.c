@@ -0,0 +1,87 @@
+#include "../include/engine.h"
+#include "../include/graphics.h"
+#include "../include/platform.h"
+#include <stdio.h>
+
+/* Headless regression checks; run with "make test". argv[1] is a scratch
+ * directory for the script and frame dumps. */
+
+static i32 g_failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("[%s] %s\n", ok ? "PASS" : "FAIL", what);
+    if (!ok) g_failures++;
+}
+
+static bool file_exists(const char* path) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return false;
+    fclose(fp);
+    return true;
+}
+
+/* Frames that draw nothing must still end, or frame-keyed input never
+ * arrives and nothing is dumped */
+static void test_idle_frames(const char* dir) {
+    char script[512];
+    char pattern[512];
+    char dump[512];
+    snprintf(script, sizeof(script), "%s/headless_idle.txt", dir);
+    snprintf(pattern, sizeof(pattern), "%s/headless_idle_%%d.ppm", dir);
+    snprintf(dump, sizeof(dump), "%s/headless_idle_3.ppm", dir);
+    remove(dump);
+
+    FILE* fp = fopen(script, "w");
+    if (!fp) {
+        check(false, "write idle script");
+        return;
+    }
+    fprintf(fp, "4 close\n");
+    fclose(fp);
+
+    platform_headless_config_t config = { .dump_pattern = pattern, .dump_interval = 1, .script_path = script };
+    platform_set_headless(&config);
+
+    engine_window_config_t window_config = { .title = "headless_test", .width = 32, .height = 32 };
+    engine_window_t* window = NULL;
+    graphics_context_t* gfx = graphics_create_context(32, 32);
+    if (engine_window_create(&window_config, &window) != ENGINE_SUCCESS || !gfx) {
+        check(false, "create idle window");
+        graphics_destroy_context(gfx);
+        return;
+    }
+
+    /* Draw the first frame only */
+    graphics_clear(gfx, graphics_rgb(255, 0, 0));
+    i32 frames = 0;
+    while (frames < 16) {
+        engine_poll_events();
+        if (engine_window_should_close(window)) break;
+        engine_window_present(window, gfx);
+        frames++;
+    }
+
+    check(engine_window_should_close(window), "scripted close arrives after idle frames");
+    check(frames == 4, "idle presents count as frames");
+    check(file_exists(dump), "idle frames are dumped");
+
+    engine_window_destroy(window);
+    graphics_destroy_context(gfx);
+    platform_set_headless(NULL);
+}
+
+int main(int argc, char** argv) {
+    const char* dir = argc > 1 ? argv[1] : ".";
+
+    engine_config_t config = { .app_name = "headless_test", .enable_logging = false, .job_workers = -1 };
+    if (engine_init(&config) != ENGINE_SUCCESS) {
+        fprintf(stderr, "Failed to initialize engine\n");
+        return 1;
+    }
+
+    test_idle_frames(dir);
+
+    engine_shutdown();
+    printf("%d failure%s\n", g_failures, g_failures == 1 ? "" : "s");
+    return g_failures == 0 ? 0 : 1;
+}